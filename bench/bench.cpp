@@ -0,0 +1,404 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <ctrl/ctrl.h>
+
+// Every allocation made by the process is counted, so the allocations of a
+// single operation can be derived from the counter before and after it.
+static std::atomic<unsigned long long> s_allocations(0);
+
+void* operator new(std::size_t size) {
+   s_allocations.fetch_add(1, std::memory_order_relaxed);
+   void* p = std::malloc(size == 0 ? 1 : size);
+   if (p == 0) {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void* operator new[](std::size_t size) {
+   return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+   std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+   std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+   std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+   std::free(p);
+}
+
+//******************************************************************************
+
+class FlatPod {
+public:
+   static FlatPod create(std::mt19937& random) {
+      FlatPod obj;
+      obj.m_int = random();
+      obj.m_long = random() * 4096LL;
+      obj.m_double = random() / 3.0;
+      obj.m_float = random() / 7.0f;
+      obj.m_bool = random() % 2 == 0;
+      obj.m_char = 'a' + random() % 26;
+      obj.m_unsigned = random();
+      obj.m_short = random() % 1000;
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(FlatPod)
+   CTRL_MEMBER(private, int, m_int)
+   CTRL_MEMBER(private, long long, m_long)
+   CTRL_MEMBER(private, double, m_double)
+   CTRL_MEMBER(private, float, m_float)
+   CTRL_MEMBER(private, bool, m_bool)
+   CTRL_MEMBER(private, char, m_char)
+   CTRL_MEMBER(private, unsigned int, m_unsigned)
+   CTRL_MEMBER(private, short, m_short)
+   CTRL_END_MEMBERS()
+};
+
+std::string randomString(std::mt19937& random, std::size_t minLength, std::size_t maxLength) {
+   std::string result(minLength + random() % (maxLength - minLength + 1), ' ');
+   for (std::string::iterator iter = result.begin(); iter != result.end(); ++iter) {
+      *iter = 'a' + random() % 26;
+   }
+   return result;
+}
+
+class WideClass {
+public:
+   static WideClass create(std::mt19937& random) {
+      WideClass obj;
+      obj.m_int0 = random(); obj.m_int1 = random(); obj.m_int2 = random(); obj.m_int3 = random();
+      obj.m_int4 = random(); obj.m_int5 = random(); obj.m_int6 = random(); obj.m_int7 = random();
+      obj.m_double0 = random() / 3.0; obj.m_double1 = random() / 3.0; obj.m_double2 = random() / 3.0;
+      obj.m_double3 = random() / 3.0; obj.m_double4 = random() / 3.0; obj.m_double5 = random() / 3.0;
+      obj.m_double6 = random() / 3.0; obj.m_double7 = random() / 3.0;
+      obj.m_string0 = randomString(random, 4, 24); obj.m_string1 = randomString(random, 4, 24);
+      obj.m_string2 = randomString(random, 4, 24); obj.m_string3 = randomString(random, 4, 24);
+      obj.m_string4 = randomString(random, 4, 24); obj.m_string5 = randomString(random, 4, 24);
+      obj.m_string6 = randomString(random, 4, 24); obj.m_string7 = randomString(random, 4, 24);
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(WideClass)
+   CTRL_MEMBER(private, int, m_int0)
+   CTRL_MEMBER(private, int, m_int1)
+   CTRL_MEMBER(private, int, m_int2)
+   CTRL_MEMBER(private, int, m_int3)
+   CTRL_MEMBER(private, int, m_int4)
+   CTRL_MEMBER(private, int, m_int5)
+   CTRL_MEMBER(private, int, m_int6)
+   CTRL_MEMBER(private, int, m_int7)
+   CTRL_MEMBER(private, double, m_double0)
+   CTRL_MEMBER(private, double, m_double1)
+   CTRL_MEMBER(private, double, m_double2)
+   CTRL_MEMBER(private, double, m_double3)
+   CTRL_MEMBER(private, double, m_double4)
+   CTRL_MEMBER(private, double, m_double5)
+   CTRL_MEMBER(private, double, m_double6)
+   CTRL_MEMBER(private, double, m_double7)
+   CTRL_MEMBER(private, std::string, m_string0)
+   CTRL_MEMBER(private, std::string, m_string1)
+   CTRL_MEMBER(private, std::string, m_string2)
+   CTRL_MEMBER(private, std::string, m_string3)
+   CTRL_MEMBER(private, std::string, m_string4)
+   CTRL_MEMBER(private, std::string, m_string5)
+   CTRL_MEMBER(private, std::string, m_string6)
+   CTRL_MEMBER(private, std::string, m_string7)
+   CTRL_END_MEMBERS()
+};
+
+class TreeNode {
+public:
+   static TreeNode create(std::mt19937& random, int depth, int fanOut) {
+      TreeNode node;
+      node.m_value = random();
+      node.m_label = randomString(random, 4, 12);
+      if (depth > 0) {
+         for (int i = 0; i < fanOut; ++i) {
+            node.m_children.push_back(create(random, depth - 1, fanOut));
+         }
+      }
+      return node;
+   }
+
+   CTRL_BEGIN_MEMBERS(TreeNode)
+   CTRL_MEMBER(private, int, m_value)
+   CTRL_MEMBER(private, std::string, m_label)
+   CTRL_MEMBER(private, std::vector<TreeNode>, m_children)
+   CTRL_END_MEMBERS()
+};
+
+class NumericVectors {
+public:
+   static NumericVectors create(std::mt19937& random, std::size_t size) {
+      NumericVectors obj;
+      std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+      for (std::size_t i = 0; i < size; ++i) {
+         obj.m_doubles.push_back(distribution(random));
+         obj.m_ints.push_back(random());
+      }
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(NumericVectors)
+   CTRL_MEMBER(private, std::vector<double>, m_doubles)
+   CTRL_MEMBER(private, std::vector<int>, m_ints)
+   CTRL_END_MEMBERS()
+};
+
+class StringMap {
+public:
+   typedef std::map<std::string, std::string> Entries;
+
+   static StringMap create(std::mt19937& random, std::size_t size) {
+      StringMap obj;
+      while (obj.m_entries.size() < size) {
+         obj.m_entries[randomString(random, 8, 24)] = randomString(random, 16, 64);
+      }
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(StringMap)
+   CTRL_MEMBER(private, Entries, m_entries)
+   CTRL_END_MEMBERS()
+};
+
+class Shape {
+public:
+   virtual ~Shape() { }
+
+   CTRL_BEGIN_MEMBERS(Shape)
+   CTRL_MEMBER(protected, int, m_color)
+   CTRL_END_MEMBERS()
+};
+
+CTRL_ABSTRACT_POLYMORPH(Shape)
+
+class Circle : public Shape {
+public:
+   Circle(std::mt19937& random) : m_x(random() / 7.0f), m_y(random() / 7.0f), m_radius(random() / 7.0f) {
+      m_color = random();
+   }
+
+   CTRL_BEGIN_MEMBERS(Circle)
+   CTRL_BASE_CLASS(Shape)
+   CTRL_MEMBER(private, float, m_x)
+   CTRL_MEMBER(private, float, m_y)
+   CTRL_MEMBER(private, float, m_radius)
+   CTRL_END_MEMBERS()
+};
+
+CTRL_POLYMORPH(Circle)
+
+class Rectangle : public Shape {
+public:
+   Rectangle(std::mt19937& random) : m_x(random() / 7.0f), m_y(random() / 7.0f),
+         m_width(random() / 7.0f), m_height(random() / 7.0f) {
+      m_color = random();
+   }
+
+   CTRL_BEGIN_MEMBERS(Rectangle)
+   CTRL_BASE_CLASS(Shape)
+   CTRL_MEMBER(private, float, m_x)
+   CTRL_MEMBER(private, float, m_y)
+   CTRL_MEMBER(private, float, m_width)
+   CTRL_MEMBER(private, float, m_height)
+   CTRL_END_MEMBERS()
+};
+
+CTRL_POLYMORPH(Rectangle)
+
+class Drawing {
+public:
+   static Drawing create(std::mt19937& random, std::size_t size) {
+      Drawing obj;
+      for (std::size_t i = 0; i < size; ++i) {
+         if (random() % 2 == 0) {
+            obj.m_shapes.push_back(std::shared_ptr<Shape>(new Circle(random)));
+         } else {
+            obj.m_shapes.push_back(std::shared_ptr<Shape>(new Rectangle(random)));
+         }
+      }
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(Drawing)
+   CTRL_MEMBER(private, std::vector<std::shared_ptr<Shape>>, m_shapes)
+   CTRL_END_MEMBERS()
+};
+
+class Item {
+public:
+   CTRL_BEGIN_MEMBERS(Item)
+   CTRL_MEMBER(public, int, m_id)
+   CTRL_MEMBER(public, std::string, m_name)
+   CTRL_END_MEMBERS()
+};
+
+// Every item is referenced from several places, so most pointers are written
+// as references to an item that was already written.
+class SharedGraph {
+public:
+   static SharedGraph create(std::mt19937& random, std::size_t size, std::size_t references) {
+      std::vector<std::shared_ptr<Item>> items;
+      for (std::size_t i = 0; i < size; ++i) {
+         std::shared_ptr<Item> item(new Item());
+         item->m_id = i;
+         item->m_name = randomString(random, 4, 16);
+         items.push_back(item);
+      }
+      SharedGraph obj;
+      for (std::size_t i = 0; i < size * references; ++i) {
+         obj.m_references.push_back(items[random() % size]);
+      }
+      return obj;
+   }
+
+   CTRL_BEGIN_MEMBERS(SharedGraph)
+   CTRL_MEMBER(private, std::vector<std::shared_ptr<Item>>, m_references)
+   CTRL_END_MEMBERS()
+};
+
+//******************************************************************************
+
+struct Options {
+   Options() : minTime(0.25), filter("") { }
+
+   double minTime;
+   std::string filter;
+};
+
+struct Measurement {
+   double nsPerOp;
+   double allocationsPerOp;
+};
+
+// Runs the operation in batches that double in size until a batch takes at
+// least the minimum time, after a single warm up run.
+Measurement measure(const std::function<void()>& operation, const Options& options) {
+   operation();
+   typedef std::chrono::steady_clock Clock;
+   for (unsigned long long iterations = 1; ; iterations *= 2) {
+      unsigned long long allocations = s_allocations.load(std::memory_order_relaxed);
+      Clock::time_point start = Clock::now();
+      for (unsigned long long i = 0; i < iterations; ++i) {
+         operation();
+      }
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (seconds >= options.minTime) {
+         Measurement result;
+         result.nsPerOp = seconds * 1e9 / iterations;
+         result.allocationsPerOp = double(s_allocations.load(std::memory_order_relaxed) - allocations) / iterations;
+         return result;
+      }
+   }
+}
+
+void report(const std::string& name, const char* format, const char* operation, std::size_t bytes,
+            const Measurement& measurement) {
+   std::printf("%-16s %-6s %-6s %12zu %14.0f %10.1f %12.1f\n", name.c_str(), format, operation, bytes,
+               measurement.nsPerOp, bytes / measurement.nsPerOp * 1e9 / (1024 * 1024), measurement.allocationsPerOp);
+}
+
+template <class T>
+void benchmark(const std::string& name, const T& obj, const Options& options) {
+   if (name.find(options.filter) == std::string::npos) {
+      return;
+   }
+
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   report(name, "binary", "write", length, measure([&obj]() {
+      long length;
+      delete[] ctrl::toBinary(obj, length);
+   }, options));
+   report(name, "binary", "read", length, measure([bytes, length]() {
+      delete ctrl::fromBinary<T>(bytes, length);
+   }, options));
+   delete[] bytes;
+
+   std::string xml = ctrl::toXml(obj);
+   report(name, "xml", "write", xml.size(), measure([&obj]() {
+      ctrl::toXml(obj);
+   }, options));
+   report(name, "xml", "read", xml.size(), measure([&xml]() {
+      delete ctrl::fromXml<T>(xml);
+   }, options));
+
+   std::string json = ctrl::toJson(obj);
+   report(name, "json", "write", json.size(), measure([&obj]() {
+      ctrl::toJson(obj);
+   }, options));
+   report(name, "json", "read", json.size(), measure([&json]() {
+      delete ctrl::fromJson<T>(json);
+   }, options));
+}
+
+int main(int argc, char** argv) {
+   Options options;
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--quick") == 0) {
+         options.minTime = 0.02;
+      } else {
+         options.filter = argv[i];
+      }
+   }
+
+   // A fixed seed keeps the data, and therefore the results, comparable between runs.
+   std::mt19937 random(42);
+
+   std::printf("%-16s %-6s %-6s %12s %14s %10s %12s\n", "case", "format", "op", "bytes", "ns/op", "MB/s", "allocs/op");
+   benchmark("flat-pod", FlatPod::create(random), options);
+   benchmark("wide-class", WideClass::create(random), options);
+   benchmark("deep-tree", TreeNode::create(random, 6, 4), options);
+   benchmark("numeric-1k", NumericVectors::create(random, 1000), options);
+   benchmark("numeric-100k", NumericVectors::create(random, 100000), options);
+   benchmark("string-map", StringMap::create(random, 10000), options);
+   benchmark("polymorphic", Drawing::create(random, 10000), options);
+   benchmark("shared-graph", SharedGraph::create(random, 2500, 4), options);
+   return 0;
+}
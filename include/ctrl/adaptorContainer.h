@@ -0,0 +1,59 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ADAPTORCONTAINER_H_
+#define ADAPTORCONTAINER_H_
+
+namespace ctrl {
+
+namespace Private {
+
+   // Gives access to the protected container of std::queue, std::stack and
+   // std::priority_queue, so they can be serialized without copying or popping.
+   template <class Adaptor_>
+   class AdaptorContainer : private Adaptor_ {
+   public:
+      typedef typename Adaptor_::container_type Container;
+
+      static const Container& get(const Adaptor_& adaptor) {
+         return adaptor.*(&AdaptorContainer::c);
+      }
+
+      static Container& get(Adaptor_& adaptor) {
+         return adaptor.*(&AdaptorContainer::c);
+      }
+
+      template <class Comp_>
+      static const Comp_& comparator(const Adaptor_& adaptor) {
+         return adaptor.*(&AdaptorContainer::comp);
+      }
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // ADAPTORCONTAINER_H_
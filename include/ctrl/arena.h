@@ -0,0 +1,196 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <ctrl/typemanip.h>
+
+namespace ctrl {
+
+   // Monotonic memory arena. Memory is handed out from large blocks and only
+   // released all at once by reset or when the arena is destroyed. Objects that
+   // need their destructor run register it, and the registered destructors run,
+   // newest first, before the memory is released. Deserialization functions that
+   // take an arena make it the current arena of the calling thread, so that
+   // ArenaAllocator instances created while reading allocate from it.
+   class Arena {
+   public:
+      explicit Arena(std::size_t blockSize = 64 * 1024);
+      ~Arena();
+
+      void* allocate(std::size_t size, std::size_t alignment);
+
+      typedef void (*DestroyFunction)(void*);
+
+      // Calls destroy with object on reset or when the arena is destroyed.
+      void addDestructor(DestroyFunction destroy, void* object);
+
+      // Runs the destructors registered after the first count ones right away,
+      // to clean up after a read that failed. Their memory stays allocated until
+      // reset.
+      std::size_t destructorCount() const;
+      void runDestructors(std::size_t count);
+
+      // Runs all destructors and releases all allocations, keeping the most
+      // recent block for reuse.
+      void reset();
+
+      std::size_t allocated() const;
+
+      static Arena* current();
+
+   private:
+      friend class ArenaScope;
+
+      struct Block {
+         Block* next;
+         std::size_t size;
+      };
+
+      struct Destructor {
+         Destructor* next;
+         DestroyFunction destroy;
+         void* object;
+      };
+
+      Arena(const Arena&);
+      Arena& operator=(const Arena&);
+
+      void addBlock(std::size_t minimumSize);
+
+      Block* m_blocks;
+      Destructor* m_destructors;
+      std::size_t m_destructorCount;
+      char* m_cursor;
+      char* m_end;
+      std::size_t m_blockSize;
+      std::size_t m_allocated;
+   };
+
+   // Makes an arena the current arena of the calling thread for its lifetime.
+   class ArenaScope {
+   public:
+      explicit ArenaScope(Arena& arena);
+      ~ArenaScope();
+
+   private:
+      ArenaScope(const ArenaScope&);
+      ArenaScope& operator=(const ArenaScope&);
+
+      Arena* m_previous;
+   };
+
+   // Allocator that takes its memory from an arena. A default constructed
+   // allocator binds to the current arena of the thread, or to the global heap
+   // when there is none, so containers that are members of deserialized objects
+   // pick up the arena passed to the deserialization function.
+   template <class T>
+   class ArenaAllocator {
+   public:
+      typedef T value_type;
+      typedef std::true_type propagate_on_container_move_assignment;
+      typedef std::true_type propagate_on_container_swap;
+
+      template <class U>
+      struct rebind { typedef ArenaAllocator<U> other; };
+
+      ArenaAllocator() : m_arena(Arena::current()) { }
+
+      explicit ArenaAllocator(Arena* arena) : m_arena(arena) { }
+
+      template <class U>
+      ArenaAllocator(const ArenaAllocator<U>& that) : m_arena(that.arena()) { }
+
+      T* allocate(std::size_t n) {
+         if (m_arena != 0) {
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+         }
+         return static_cast<T*>(::operator new(n * sizeof(T)));
+      }
+
+      void deallocate(T* p, std::size_t) {
+         if (m_arena == 0) {
+            ::operator delete(p);
+         }
+      }
+
+      Arena* arena() const {
+         return m_arena;
+      }
+
+   private:
+      Arena* m_arena;
+   };
+
+   template <class T, class U>
+   bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+      return lhs.arena() == rhs.arena();
+   }
+
+   template <class T, class U>
+   bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+      return lhs.arena() != rhs.arena();
+   }
+
+   typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+namespace Private {
+
+   template <>
+   struct IsFundamental<ArenaString> { enum { value = true }; };
+
+   template <class ConcreteClass_>
+   void destroyObject(void* object) {
+      reinterpret_cast<ConcreteClass_*>(object)->~ConcreteClass_();
+   }
+
+   // Creates an object in the current arena, or on the heap when there is none.
+   template <class ConcreteClass_>
+   ConcreteClass_* createObject() {
+      Arena* arena = Arena::current();
+      if (arena == 0) {
+         return new ConcreteClass_();
+      }
+      ConcreteClass_* object = new (arena->allocate(sizeof(ConcreteClass_), alignof(ConcreteClass_))) ConcreteClass_();
+      if (!std::is_trivially_destructible<ConcreteClass_>::value) {
+         try {
+            arena->addDestructor(&destroyObject<ConcreteClass_>, object);
+         }
+         catch(...) { object->~ConcreteClass_(); throw; }
+      }
+      return object;
+   }
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // ARENA_H_
@@ -33,6 +33,7 @@
 #include <ctrl/buffer/readPointerRepository.h>
 #include <ctrl/buffer/readRawPointerRepository.h>
 #include <ctrl/exception.h>
+#include <ctrl/limits.h>
 
 namespace ctrl {
 
@@ -46,6 +47,44 @@ namespace ctrl {
       Private::ReadPointerRepository<std::shared_ptr, std::weak_ptr>& getStdPointerRepository();
       Private::ReadPointerRepository<boost::shared_ptr, boost::weak_ptr>& getBoostPointerRepository();
       Private::ReadRawPointerRepository& getRawPointerRepository();
+      void clearPointerRepositories();
+
+      // The limits are checked by the deserialize functions. Parts handed out
+      // by readPart start from the limits, depth and allocation of the buffer
+      // they were taken from.
+      void setLimits(const Limits& limits);
+      const Limits& getLimits() const;
+
+      // Starts counting depth and allocations from zero again, keeping the
+      // limits, for a buffer that reads more than one input.
+      void resetLimitCounters();
+
+      // Charges the allocations made while reading a part handed out by readPart
+      // to this buffer, once the part has been read.
+      void addPartAllocations(const AbstractReadBuffer& part) throw(Exception) {
+         allocate(part.m_allocated - part.m_inheritedAllocated, 1);
+      }
+
+      void checkCollectionSize(std::size_t size, std::size_t elementSize) throw(Exception) {
+         if (size > m_limits.maxCollectionSize)
+            throw Exception("Collection size exceeds the limit");
+         allocate(size, elementSize);
+      }
+
+      void checkStringLength(std::size_t length) throw(Exception) {
+         if (length > m_limits.maxStringLength)
+            throw Exception("String length exceeds the limit");
+         allocate(length, 1);
+      }
+
+      void enterNesting() throw(Exception) {
+         if (++m_depth > m_limits.maxDepth)
+            throw Exception("Nesting depth exceeds the limit");
+      }
+
+      void leaveNesting() {
+         --m_depth;
+      }
 
       virtual void enterObject(const Context& context) throw(Exception) = 0;
       virtual void enterMember(const Context& context, const char* suggested = 0) throw(Exception) = 0;
@@ -70,6 +109,33 @@ namespace ctrl {
       virtual void readVersion(int& version, const Context& context) throw(Exception) = 0;
       virtual void readBits(char* data, long length, const Context& context) throw(Exception) = 0;
       virtual void readCollectionSize(std::size_t& size, const Context& context) throw(Exception) = 0;
+      // Number of elements worth reserving for a collection of the given size. Binary
+      // buffers cap it by the number of elements of at least minElementSize bytes
+      // that fit in the remaining input, so a corrupt size can't cause a huge
+      // allocation.
+      virtual std::size_t reservableSize(std::size_t size, std::size_t minElementSize) const;
+      // Binary buffers treat a collection whose elements of at least minElementSize
+      // bytes can't fit in the remaining input as corrupt. When errors are recorded
+      // instead of thrown, the size is set to zero, as it is for any collection read
+      // after an error, so the deserializers don't keep reading a truncated input.
+      virtual void checkEncodedSize(std::size_t& size, std::size_t minElementSize) throw(Exception);
+
+      // Buffers that can read parts of a collection independently hand out a
+      // buffer over the next length bytes of the input. leavePart is called on
+      // the part once it has been read. Parts can be split again, but are
+      // already read on a thread of their own, which isPart tells.
+      virtual bool hasParts() const;
+      virtual AbstractReadBuffer* readPart(std::size_t length) throw(Exception);
+      virtual void leavePart() throw(Exception);
+      virtual bool isPart() const;
+
+      // Called once the root object has been read. Buffers that only scan the
+      // input as far as they need check the rest of it here.
+      virtual void leaveRoot() throw(Exception);
+
+      // Number of bytes consumed so far, 0 if the buffer doesn't keep track.
+      virtual std::size_t position() const;
+
       virtual void readTypeId(std::string& val, const Context& context) throw(Exception) = 0;
 
       virtual void read(bool& val, const Context& context) throw(Exception) = 0;
@@ -86,16 +152,30 @@ namespace ctrl {
       virtual void read(float& val, const Context& context) throw(Exception) = 0;
       virtual void read(double& val, const Context& context) throw(Exception) = 0;
       virtual void read(std::string& val, const Context& context) throw(Exception) = 0;
+      virtual void read(std::wstring& val, const Context& context) throw(Exception);
 
    protected:
       AbstractReadBuffer();
 
+      void inheritLimits(const AbstractReadBuffer& that);
+
    private:
       AbstractReadBuffer(const AbstractReadBuffer&);
 
+      void allocate(std::size_t count, std::size_t size) throw(Exception) {
+         if (count > (m_limits.maxAllocation - m_allocated) / size)
+            throw Exception("Allocation exceeds the limit");
+         m_allocated += count * size;
+      }
+
       Private::ReadPointerRepository<std::shared_ptr, std::weak_ptr> m_stdPointerRepository;
       Private::ReadPointerRepository<boost::shared_ptr, boost::weak_ptr> m_boostPointerRepository;
       Private::ReadRawPointerRepository m_rawPointerRepository;
+      std::string m_utf8;
+      Limits m_limits;
+      std::size_t m_depth;
+      std::size_t m_allocated;
+      std::size_t m_inheritedAllocated;
    };
 
 } // namespace ctrl
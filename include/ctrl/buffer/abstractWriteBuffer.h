@@ -42,6 +42,30 @@ namespace ctrl {
 
       Private::WritePointerRepository& getPointerRepository();
 
+      virtual void reset();
+
+      // Buffers that can write parts of a collection independently return a new
+      // empty buffer here, which is later added in order with appendPart. Parts
+      // can be split again, but are already written on a thread of their own,
+      // which isPart tells.
+      virtual AbstractWriteBuffer* createPart() const;
+      virtual std::size_t partLength(AbstractWriteBuffer& part) const;
+      virtual void appendPart(AbstractWriteBuffer& part) throw(Exception);
+      virtual bool isPart() const;
+
+      // Buffers that can splice in data encoded earlier return a new empty buffer
+      // of their format here, to be added as often as needed with appendPart
+      // while isSameFormat holds.
+      virtual AbstractWriteBuffer* createCache() const;
+      virtual bool isSameFormat(const AbstractWriteBuffer& cache) const;
+
+      // Releases the memory reserved beyond the data written so far, for
+      // buffers that are kept around once they are complete.
+      virtual void shrinkToFit();
+
+      // Number of bytes written so far, 0 if the buffer doesn't keep track.
+      virtual std::size_t position() const;
+
       virtual void enterObject(const Context& context) throw(Exception) = 0;
       virtual void enterMember(const Context& context, const char* suggested = 0) throw(Exception) = 0;
       virtual void leaveMember(const Context& context) throw(Exception) = 0;
@@ -82,12 +106,14 @@ namespace ctrl {
       virtual void append(const float& val, const Context& context) throw(Exception) = 0;
       virtual void append(const double& val, const Context& context) throw(Exception) = 0;
       virtual void append(const std::string& val, const Context& context) throw(Exception) = 0;
+      virtual void append(const std::wstring& val, const Context& context) throw(Exception);
 
    protected:
       AbstractWriteBuffer();
 
    private:
       Private::WritePointerRepository m_pointerRepository;
+      std::string m_utf8;
    };
 
 } // namespace ctrl
@@ -56,12 +56,35 @@ namespace Private {
          virtual void read(float& val) throw(Exception) = 0;
          virtual void read(double& val) throw(Exception) = 0;
          virtual void read(std::string& val) throw(Exception) = 0;
+         virtual void read(std::wstring& val) throw(Exception) = 0;
          virtual void read(char* data, long length) throw(Exception) = 0;
          virtual bool reachedEnd() const = 0;
+         virtual std::size_t remaining() const = 0;
+         virtual Impl* readPart(std::size_t length) throw(Exception) = 0;
+         virtual void failAtCursor() throw(Exception) = 0;
+
+         // When errors are recorded a read past the end of the input doesn't
+         // throw. The position of the first one is kept, the value read is zero
+         // and the input is skipped to its end, so the remaining reads finish
+         // quickly without unwinding the stack.
+         void recordErrors();
+         bool failed() const;
+         std::size_t errorPosition() const;
+
+      protected:
+         void fail(std::size_t position) throw(Exception);
+
+      private:
+         bool m_recordErrors;
+         bool m_failed;
+         std::size_t m_errorPosition;
       }; // class Impl
 
       BinaryReadBuffer(Impl* pimpl);
 
+      // Continues with new input, keeping the pointers read so far.
+      void setInput(Impl* pimpl);
+
       virtual void enterObject(const Context& context) throw(Exception);
       virtual void enterMember(const Context& context, const char* suggested = 0) throw(Exception);
       virtual void leaveMember(const Context& context) throw(Exception);
@@ -85,6 +108,15 @@ namespace Private {
       virtual void readVersion(int& version, const Context& context) throw(Exception);
       virtual void readBits(char* data, long length, const Context& context) throw(Exception);
       virtual void readCollectionSize(std::size_t& size, const Context& context) throw(Exception);
+      virtual std::size_t reservableSize(std::size_t size, std::size_t minElementSize) const;
+      virtual void checkEncodedSize(std::size_t& size, std::size_t minElementSize) throw(Exception);
+      virtual bool hasParts() const;
+      virtual AbstractReadBuffer* readPart(std::size_t length) throw(Exception);
+      virtual void leavePart() throw(Exception);
+      virtual bool isPart() const;
+
+      virtual std::size_t position() const;
+
       virtual void readTypeId(std::string& val, const Context& context) throw(Exception);
 
       virtual void read(bool& val, const Context& context) throw(Exception);
@@ -101,14 +133,22 @@ namespace Private {
       virtual void read(float& val, const Context& context) throw(Exception);
       virtual void read(double& val, const Context& context) throw(Exception);
       virtual void read(std::string& val, const Context& context) throw(Exception);
+      virtual void read(std::wstring& val, const Context& context) throw(Exception);
 
       bool reachedEnd() const;
+      std::size_t remaining() const;
+
+      void recordErrors();
+      bool failed() const;
+      std::size_t errorPosition() const;
 
    private:
       BinaryReadBuffer(const BinaryReadBuffer&);
 
       std::unique_ptr<Impl> m_pimpl;
       bool m_skipNextFundamental;
+      bool m_isPart;
+      std::size_t m_size;
    };
 
 } // namespace Private
@@ -27,8 +27,10 @@
 #ifndef READBUFFERIMPL_H_
 #define READBUFFERIMPL_H_
 
+#include <algorithm>
 #include <ctrl/buffer/binaryReadBuffer.h>
 #include <ctrl/buffer/integerConvertor.h>
+#include <ctrl/buffer/utfConvertor.h>
 #include <ctrl/platformFormat.h>
 #include <ctrl/exception.h>
 
@@ -43,7 +45,8 @@ namespace Private {
       union DoubleUnion { double d; long long l; };
    public:
       BinaryReadBufferImpl(const char* data, const long& length)
-         : m_data(data)
+         : m_dataBegin(data)
+         , m_data(data)
          , m_dataEnd(data + length) {
 
       }
@@ -78,16 +81,35 @@ namespace Private {
          std::string::size_type length;
          readNumber(length);
          std::string::size_type advance = length + (alignment_ - length % alignment_) % alignment_;
-         if (m_data + advance > m_dataEnd)
-            throw Exception("Input data is corrupt");
-         val = std::string(m_data, length);
+         if (advance < length || advance > remaining()) {
+            failAtCursor();
+            val.clear();
+            return;
+         }
+         val.assign(m_data, length);
+         m_data += advance;
+      }
+
+      virtual void read(std::wstring& val) throw(Exception) {
+         std::string::size_type length;
+         readNumber(length);
+         std::string::size_type advance = length + (alignment_ - length % alignment_) % alignment_;
+         if (advance < length || advance > remaining()) {
+            failAtCursor();
+            val.clear();
+            return;
+         }
+         UtfConvertor::assignWide(val, m_data, m_data + length);
          m_data += advance;
       }
 
       virtual void read(char* data, long length) throw(Exception) {
          long advance = length + (alignment_ - length % alignment_) % alignment_;
-         if (m_data + advance > m_dataEnd)
-            throw Exception("Input data is corrupt");
+         if (advance < 0 || static_cast<std::size_t>(advance) > remaining()) {
+            failAtCursor();
+            std::fill(data, data + length, 0);
+            return;
+         }
          for (long i = 0; i < length; ++i)
             *(data + i) = *(m_data + i);
          m_data += advance;
@@ -97,16 +119,37 @@ namespace Private {
          return m_data == m_dataEnd;
       }
 
+      virtual std::size_t remaining() const {
+         return m_dataEnd - m_data;
+      }
+
+      virtual Impl* readPart(std::size_t length) throw(Exception) {
+         if (length > remaining())
+            throw Exception("Input data is corrupt", m_data - m_dataBegin);
+         Impl* part = new BinaryReadBufferImpl<alignment_, endian_>(m_data, length);
+         m_data += length;
+         return part;
+      }
+
+      virtual void failAtCursor() throw(Exception) {
+         fail(m_data - m_dataBegin);
+         m_data = m_dataEnd;
+      }
+
    private:
       template <typename Number_>
       void readNumber(Number_& n) throw(Exception) {
-         if (m_data + sizeof(Number_) + (alignment_ - sizeof(Number_) % alignment_) % alignment_ > m_dataEnd)
-            throw Exception("Input data is corrupt");
+         if (sizeof(Number_) + (alignment_ - sizeof(Number_) % alignment_) % alignment_ > remaining()) {
+            failAtCursor();
+            n = Number_();
+            return;
+         }
          Number_ in = *(Number_*)(m_data);
          n = IntegerConvertor<Number_, endian_ != CTRL_BYTE_ORDER>::convert(in);
          m_data += sizeof(Number_) + (alignment_ - sizeof(Number_) % alignment_) % alignment_;
       }
 
+      const char* m_dataBegin;
       const char* m_data;
       const char* m_dataEnd;
    };
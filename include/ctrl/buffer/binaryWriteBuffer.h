@@ -44,6 +44,10 @@ namespace Private {
 
          long length();
          char* getData();
+         const char* data() const;
+         void reset();
+         void truncate(long length);
+         void shrinkToFit();
 
          virtual void append(const bool& val) = 0;
          virtual void append(const char& val) = 0;
@@ -59,11 +63,16 @@ namespace Private {
          virtual void append(const float& val) = 0;
          virtual void append(const double& val) = 0;
          virtual void append(const std::string& val) = 0;
+         virtual void append(const std::wstring& val) = 0;
          virtual void append(const char* data, long length) = 0;
+         virtual void overwrite(long offset, const std::size_t& val) = 0;
+         virtual Impl* createEmpty() const = 0;
 
       protected:
          static const char* s_padding;
          void appendNoPadding(const char* data, long length);
+         char* appendUninitialized(long length);
+         char* dataAt(long offset);
          void realloc(long newLength);
 
       private:
@@ -115,13 +124,37 @@ namespace Private {
       virtual void append(const float& val, const Context& context) throw(Exception);
       virtual void append(const double& val, const Context& context) throw(Exception);
       virtual void append(const std::string& val, const Context& context) throw(Exception);
+      virtual void append(const std::wstring& val, const Context& context) throw(Exception);
+
+      virtual void reset();
+      virtual AbstractWriteBuffer* createPart() const;
+      virtual std::size_t partLength(AbstractWriteBuffer& part) const;
+      virtual void appendPart(AbstractWriteBuffer& part) throw(Exception);
+      virtual bool isPart() const;
+      virtual AbstractWriteBuffer* createCache() const;
+      virtual bool isSameFormat(const AbstractWriteBuffer& cache) const;
+      virtual void shrinkToFit();
+
+      virtual std::size_t position() const;
+
+      // Sizes that are only known after the data they describe has been
+      // written, such as the length of a record, are appended as a placeholder
+      // and filled in afterwards.
+      long appendSizePlaceholder();
+      void patchSize(long offset, const std::size_t& size);
+
+      // Drops everything written after the given length. Only data that didn't
+      // register pointers may be dropped, the pointer ids are kept.
+      void truncate(long length);
 
       long length();
       char* getData();
+      const char* data() const;
 
    private:
       std::unique_ptr<Impl> m_pimpl;
       bool m_skipNextFundamental;
+      bool m_isPart;
    };
 
 } // namespace Private
@@ -27,9 +27,11 @@
 #ifndef WRITEBUFFERIMPL_H_
 #define WRITEBUFFERIMPL_H_
 
+#include <algorithm>
 #include <ctrl/platformFormat.h>
 #include <ctrl/buffer/binaryWriteBuffer.h>
 #include <ctrl/buffer/integerConvertor.h>
+#include <ctrl/buffer/utfConvertor.h>
 
 namespace ctrl {
 
@@ -74,11 +76,30 @@ namespace Private {
          appendNoPadding(s_padding, (alignment_ - (length % alignment_)) % alignment_);
       }
 
+      virtual void append(const std::wstring& val) {
+         const wchar_t* begin = val.data();
+         const wchar_t* end = begin + val.length();
+         std::string::size_type length = UtfConvertor::utf8Length(begin, end);
+         append(length);
+         UtfConvertor::toUtf8(begin, end, appendUninitialized(length));
+         appendNoPadding(s_padding, (alignment_ - (length % alignment_)) % alignment_);
+      }
+
       virtual void append(const char* data, long length) {
          appendNoPadding(data, length);
          appendNoPadding(s_padding, (alignment_ - (length % alignment_)) % alignment_);
       }
 
+      virtual Impl* createEmpty() const {
+         return new BinaryWriteBufferImpl<alignment_, endian_>();
+      }
+
+      virtual void overwrite(long offset, const std::size_t& val) {
+         std::size_t out = IntegerConvertor<std::size_t, endian_ != CTRL_BYTE_ORDER>::convert(val);
+         const char* bytes = (const char*)(&out);
+         std::copy(bytes, bytes + sizeof(std::size_t), dataAt(offset));
+      }
+
    private:
       template <typename Number_>
       void appendNumber(const Number_& n) {
@@ -0,0 +1,128 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BITPACKING_H
+#define BITPACKING_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Conversion between std::bitset and the packed bytes passed to appendBits and
+   // readBits, in which bit i is stored in byte i / 8 with the first bit in the
+   // most significant position. When the bitset stores its bits least
+   // significant first in consecutive bytes, which every common implementation
+   // does on a little endian host, the bytes are copied and bit reversed a word
+   // at a time. Otherwise the bits are converted one by one.
+   class BitPacking {
+   public:
+      template <std::size_t size_>
+      static void pack(const std::bitset<size_>& elements, char* data) {
+         if (hasByteLayout<size_>()) {
+            reverseBits(reinterpret_cast<const char*>(&elements), data, nbChars(size_));
+            clearPadding(data, size_);
+         } else {
+            std::memset(data, 0, nbChars(size_));
+            for (std::size_t i = 0; i < size_; ++i) {
+               data[i >> 3] |= static_cast<char>(elements[i] << (7 - (i & 7)));
+            }
+         }
+      }
+
+      template <std::size_t size_>
+      static void unpack(const char* data, std::bitset<size_>& elements) {
+         elements.reset();
+         if (hasByteLayout<size_>()) {
+            char* bytes = reinterpret_cast<char*>(&elements);
+            reverseBits(data, bytes, nbChars(size_));
+            if (size_ % 8 != 0) {
+               bytes[size_ / 8] &= static_cast<char>((1 << (size_ % 8)) - 1);
+            }
+         } else {
+            for (std::size_t i = 0; i < size_; ++i) {
+               if ((data[i >> 3] >> (7 - (i & 7))) & 1) {
+                  elements.set(i);
+               }
+            }
+         }
+      }
+
+      static std::size_t nbChars(std::size_t length) {
+         return length / 8 + (length % 8 == 0 ? 0 : 1);
+      }
+
+      // Appends the packed bits as "0x" followed by two hexadecimal digits per byte.
+      static void appendText(std::string& out, const char* data, std::size_t length);
+
+      // Reads bits written by appendText, or the older format with one '0' or
+      // '1' character per bit. Returns false if the text doesn't hold length bits.
+      static bool readText(const char* text, std::size_t textLength, char* data, std::size_t length);
+
+   private:
+      // Reverses the order of the bits within each byte.
+      static void reverseBits(const char* in, char* out, std::size_t nbChars);
+
+      static void clearPadding(char* data, std::size_t length) {
+         if (length % 8 != 0) {
+            data[length / 8] &= static_cast<char>(0xff << (8 - length % 8));
+         }
+      }
+
+      template <std::size_t size_>
+      static bool hasByteLayout() {
+         static const bool result = probeByteLayout<size_>();
+         return result;
+      }
+
+      template <std::size_t size_>
+      static bool probeByteLayout() {
+         if (size_ == 0 || sizeof(std::bitset<size_>) < nbChars(size_)) {
+            return false;
+         }
+         const std::size_t positions[] = { 0, 9, 30, 63, size_ / 2, size_ - 1 };
+         std::bitset<size_> probe;
+         std::string expected(nbChars(size_), '\0');
+         for (std::size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); ++i) {
+            if (positions[i] >= size_) {
+               continue;
+            }
+            probe.set(positions[i]);
+            expected[positions[i] / 8] |= static_cast<char>(1 << (positions[i] % 8));
+         }
+         return std::memcmp(&probe, expected.data(), expected.size()) == 0;
+      }
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // BITPACKING_H
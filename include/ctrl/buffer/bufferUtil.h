@@ -28,9 +28,13 @@
 #define BUFFERUTIL_H_
 
 #include <string>
-#include <sstream>
+#include <limits>
+#include <cctype>
 #include <ctrl/context.h>
 #include <ctrl/properties.h>
+#include <ctrl/exception.h>
+#include <ctrl/typemanip.h>
+#include <ctrl/buffer/numberFormat.h>
 
 namespace ctrl {
 
@@ -49,24 +53,94 @@ namespace ctrl {
 
       template <class T>
       std::string toString(const T& val) {
-         m_toString.str("");
-         m_toString.clear();
-         m_toString << val;
-         return m_toString.str();
+         char buffer[Private::NumberFormat::bufferSize];
+         return std::string(buffer, toChars(buffer, val));
       }
 
       template <class T>
       T fromString(const std::string& str) {
-         m_fromString.str(str);
-         m_fromString.clear();
          T val;
-         m_fromString >> val;
+         parse(str, val);
          return val;
       }
 
+      template <class T>
+      static char* toChars(char* out, const T& val) {
+         typedef typename Private::Select<std::numeric_limits<T>::is_signed, long long, unsigned long long>::Result Wide;
+         return Private::NumberFormat::format(out, static_cast<Wide>(val));
+      }
+
+      static char* toChars(char* out, const bool& val) {
+         *out = val ? '1' : '0';
+         return out + 1;
+      }
+
+      static char* toChars(char* out, const char& val) {
+         *out = val;
+         return out + 1;
+      }
+
+      static char* toChars(char* out, const unsigned char& val) {
+         *out = static_cast<char>(val);
+         return out + 1;
+      }
+
+      static char* toChars(char* out, const float& val) {
+         return Private::NumberFormat::format(out, val);
+      }
+
+      static char* toChars(char* out, const double& val) {
+         return Private::NumberFormat::format(out, val);
+      }
+
    private:
-      std::ostringstream m_toString;
-      std::istringstream m_fromString;
+      template <class T>
+      static void parse(const std::string& str, T& val) {
+         typedef typename Private::Select<std::numeric_limits<T>::is_signed, long long, unsigned long long>::Result Wide;
+         Wide wide;
+         parseNumber(str, wide);
+         if ( wide < static_cast<Wide>(std::numeric_limits<T>::min()) ||
+              wide > static_cast<Wide>(std::numeric_limits<T>::max()) ) {
+            throw Exception("Corrupt data: number '" + str + "' out of range");
+         }
+         val = static_cast<T>(wide);
+      }
+
+      static void parse(const std::string& str, bool& val) {
+         val = str == "1" || str == "true";
+         if (!val && str != "0" && str != "false") {
+            throw Exception("Corrupt data: '" + str + "' isn't a boolean");
+         }
+      }
+
+      static void parse(const std::string& str, char& val) {
+         val = str.empty() ? 0 : str[0];
+      }
+
+      static void parse(const std::string& str, unsigned char& val) {
+         val = str.empty() ? 0 : static_cast<unsigned char>(str[0]);
+      }
+
+      static void parse(const std::string& str, float& val) {
+         parseNumber(str, val);
+      }
+
+      static void parse(const std::string& str, double& val) {
+         parseNumber(str, val);
+      }
+
+      template <class T>
+      static void parseNumber(const std::string& str, T& val) {
+         const char* begin = str.data();
+         const char* end = begin + str.length();
+         while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+            ++begin;
+         while (begin != end && std::isspace(static_cast<unsigned char>(end[-1])))
+            --end;
+         if (Private::NumberFormat::parse(begin, end, val) != end) {
+            throw Exception("Corrupt data: '" + str + "' isn't a valid number");
+         }
+      }
    };
 
 } // namespace ctrl
@@ -28,16 +28,20 @@
 #define JSONREADBUFFER_H
 
 #include <string>
-#include <stack>
-#include <sstream>
+#include <vector>
+#include <limits>
 #include <ctrl/buffer/abstractReadBuffer.h>
 #include <ctrl/buffer/bufferUtil.h>
-#include <ctrl/nlohmann/json.hpp>
+#include <ctrl/buffer/jsonTokenizer.h>
 
 namespace ctrl {
 
 namespace Private {
 
+   // Reads the JSON text in place without building a document tree. Members are
+   // looked up at the current position first; members that were passed while
+   // searching are remembered, so out of order input is still accepted. The
+   // data string has to outlive the buffer.
    class JsonReadBuffer : public ctrl::AbstractReadBuffer {
    public:
       JsonReadBuffer(const std::string& data);
@@ -82,49 +86,114 @@ namespace Private {
       virtual void read(double& val, const Context& context) throw(Exception);
       virtual void read(std::string& val, const Context& context) throw(Exception);
 
+      virtual void leaveRoot() throw(Exception);
+      virtual std::size_t position() const;
+
+      // See JsonTokenizer::recordErrors. Missing members and elements are
+      // recorded the same way and read as if they were empty.
+      void recordErrors();
+      bool failed() const;
+      const std::string& errorReason() const;
+      std::size_t errorPosition() const;
+
    private:
-      void checkNonNull(const nlohmann::json& node, const std::string& name = "");
+      struct Frame {
+         Frame(const char* value_, bool fromFrontier_, std::size_t skippedBegin_)
+               : value(value_), cursor(0), end(0), skippedBegin(skippedBegin_),
+                 fromFrontier(fromFrontier_), iterating(false) {}
+
+         const char* value;
+         const char* cursor;
+         const char* end;
+         std::size_t skippedBegin;
+         bool fromFrontier;
+         bool iterating;
+      };
+
+      struct SkippedMember {
+         SkippedMember(const char* key_, const char* keyEnd_, const char* value_)
+               : key(key_), keyEnd(keyEnd_), value(value_) {}
+
+         const char* key;
+         const char* keyEnd;
+         const char* value;
+      };
+
+      void pushFrame(const char* value, bool fromFrontier);
+      void popFrame() throw(Exception);
+      void openFrame(Frame& frame) throw(Exception);
+      const char* frameEnd(const Frame& frame) throw(Exception);
+      const char* findMember(const std::string& name, bool& fromFrontier) throw(Exception);
+      const char* readKey(const char* p, const char*& key, const char*& keyEnd) throw(Exception);
+      const char* nextEntry(const char* p) const throw(Exception);
+      bool atClose(const char* p) const;
 
       template <class T_>
-      void readNode(nlohmann::json* node, T_& val) {
+      void readNode(T_& val) {
          if (!m_skipNextFundamental) {
             if (m_keyStart) {
                val = m_util.fromString<T_>(m_keyValue);
             } else {
-               val = node->get<T_>();
+               readValue(val);
             }
          }
       }
 
-      void readNode(nlohmann::json* node, std::string& val) {
+      void readNode(std::string& val) {
          if (!m_skipNextFundamental) {
             if (m_keyStart) {
                val = m_keyValue;
             } else {
-               val =  node->get<std::string>();
+               readValue(val);
             }
          }
       }
 
-      void readNode(nlohmann::json* node, char& val) {
+      void readNode(char& val) {
          if (!m_skipNextFundamental) {
             if (m_keyStart) {
                val = m_keyValue.c_str()[0];
             } else {
-               val =  node->get<std::string>().c_str()[0];
+               readValue(val);
             }
          }
       }
 
+      template <class T_>
+      void readValue(T_& val) {
+         Frame& frame = m_frames.back();
+         if (std::numeric_limits<T_>::is_signed) {
+            long long signedVal;
+            frame.end = m_tokenizer.readInteger(frame.value, signedVal);
+            if ( signedVal < static_cast<long long>(std::numeric_limits<T_>::min()) ||
+                  signedVal > static_cast<long long>(std::numeric_limits<T_>::max()) ) {
+               frame.end = m_tokenizer.corrupt(m_tokenizer.skipWhitespace(frame.value), "number out of range");
+            }
+            val = static_cast<T_>(signedVal);
+         } else {
+            unsigned long long unsignedVal;
+            frame.end = m_tokenizer.readUnsigned(frame.value, unsignedVal);
+            if (unsignedVal > static_cast<unsigned long long>(std::numeric_limits<T_>::max())) {
+               frame.end = m_tokenizer.corrupt(m_tokenizer.skipWhitespace(frame.value), "number out of range");
+            }
+            val = static_cast<T_>(unsignedVal);
+         }
+      }
+
+      void readValue(bool& val);
+      void readValue(char& val);
+      void readValue(float& val);
+      void readValue(double& val);
+      void readValue(std::string& val);
+
       BufferUtil m_util;
-      nlohmann::json m_document;
-      std::stack<nlohmann::json*> m_stack;
-      std::stack<nlohmann::json::iterator> m_iterStack;
-      bool m_collectionStart;
-      bool m_mapStart;
+      JsonTokenizer m_tokenizer;
+      std::vector<Frame> m_frames;
+      std::vector<SkippedMember> m_skipped;
       bool m_keyStart;
       bool m_skipNextFundamental;
       std::string m_keyValue;
+      std::string m_stringValue;
    };
 
 } // namespace ctrl
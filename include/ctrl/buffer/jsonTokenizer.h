@@ -0,0 +1,92 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef JSONTOKENIZER_H
+#define JSONTOKENIZER_H
+
+#include <string>
+#include <cstddef>
+#include <ctrl/exception.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Incremental scanner over a JSON text held in memory. All functions take a
+   // position inside the text and return the position following the scanned
+   // token, so no document tree is ever built.
+   class JsonTokenizer {
+   public:
+      JsonTokenizer(const char* begin, const char* end);
+
+      const char* begin() const;
+      const char* end() const;
+      const char* skipWhitespace(const char* p) const;
+      const char* expect(const char* p, char c) const throw(Exception);
+
+      const char* skipValue(const char* p) const throw(Exception);
+      const char* skipString(const char* p) const throw(Exception);
+      const char* skipToClose(const char* p) const throw(Exception);
+      std::size_t countEntries(const char* p, bool object) const throw(Exception);
+
+      const char* readString(const char* p, std::string& val) const throw(Exception);
+      const char* readBool(const char* p, bool& val) const throw(Exception);
+      const char* readInteger(const char* p, long long& val) const throw(Exception);
+      const char* readUnsigned(const char* p, unsigned long long& val) const throw(Exception);
+      const char* readDouble(const char* p, double& val) const throw(Exception);
+      const char* readFloat(const char* p, float& val) const throw(Exception);
+
+      bool isNull(const char* p) const;
+      bool isClose(const char* p) const;
+      bool keyEquals(const char* key, const char* keyEnd, const std::string& name) const;
+      void unescape(const char* p, const char* stringEnd, std::string& val) const throw(Exception);
+      const char* corrupt(const char* p, const std::string& reason) const throw(Exception);
+      const char* fail(const char* p, const std::string& message) const throw(Exception);
+
+      // When errors are recorded invalid input doesn't throw. The first error
+      // is kept, the value read is zero and scanning continues from the end of
+      // the text, so the remaining reads finish quickly without unwinding the
+      // stack.
+      void recordErrors();
+      bool failed() const;
+      const std::string& errorReason() const;
+      std::size_t errorPosition() const;
+
+   private:
+
+      const char* m_begin;
+      const char* m_end;
+      bool m_recordErrors;
+      mutable bool m_failed;
+      mutable std::string m_errorReason;
+      mutable std::size_t m_errorPosition;
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // JSONTOKENIZER_H
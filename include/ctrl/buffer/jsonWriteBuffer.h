@@ -29,15 +29,17 @@
 
 #include <ctrl/buffer/abstractWriteBuffer.h>
 #include <ctrl/buffer/bufferUtil.h>
-#include <ctrl/nlohmann/json.hpp>
-#include <stack>
-#include <sstream>
+#include <cmath>
+#include <vector>
 #include <string>
 
 namespace ctrl {
 
 namespace Private {
 
+   // Writes the JSON text directly while the object graph is traversed. Each
+   // value that is being written has a frame on the stack; a frame turns into an
+   // object as soon as the first member is entered.
    class JsonWriteBuffer : public ctrl::AbstractWriteBuffer {
    public:
       JsonWriteBuffer(int indentation);
@@ -83,25 +85,59 @@ namespace Private {
       virtual void append(const double& val, const Context& context) throw(Exception);
       virtual void append(const std::string& val, const Context& context) throw(Exception);
 
-      std::string getOutput() const;
+      virtual void reset();
+
+      virtual std::size_t position() const;
+
+      const std::string& getOutput();
 
    private:
+      enum State { Empty, Object, Array, Done };
+
+      struct Frame {
+         Frame() : state(Empty), entries(0), keyBegin(0) {}
+
+         State state;
+         std::size_t entries;
+         std::size_t keyBegin;
+      };
+
+      void openObject();
+      void beginEntry();
+      void writeKey(const std::string& key);
+      void writeMapKey(const std::string& key);
+      void writeScalar(const char* begin, const char* end);
+      void writeString(const std::string& val);
+      void closeFrame(Frame& frame);
+      void popFrame();
+      void appendEscaped(const std::string& val);
+
       template <class T_>
       void appendNumber(const T_& val) {
          if (m_keyStart) {
-            if (!(*m_stack.top())[m_util.toString(val)].is_null()) {
-               throw Exception("Multimaps with duplicated keys aren't supported when serializing to JSON");
-            }
-            (*m_stack.top())[m_util.toString(val)] = nlohmann::json();
-            m_stack.push(&(*m_stack.top())[m_util.toString(val)]);
+            writeMapKey(m_util.toString(val));
          } else if (!m_skipNextFundamental) {
-            (*m_stack.top()) = val;
+            char buffer[NumberFormat::bufferSize];
+            writeScalar(buffer, m_util.toChars(buffer, val));
+         }
+      }
+
+      // JSON has no literal for NaN or the infinities, so like other JSON writers
+      // null is written for them. It reads back as NaN.
+      template <class T_>
+      void appendFloatingPoint(const T_& val) {
+         if (!m_keyStart && !m_skipNextFundamental && !std::isfinite(val)) {
+            static const char nullText[] = "null";
+            writeScalar(nullText, nullText + 4);
+         } else {
+            appendNumber(val);
          }
       }
 
       BufferUtil m_util;
-      nlohmann::json m_document;
-      std::stack<nlohmann::json*> m_stack;
+      std::string m_output;
+      std::string m_keys;
+      std::vector<Frame> m_frames;
       bool m_collectionStart;
       bool m_mapStart;
       bool m_keyStart;
@@ -0,0 +1,61 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <cstddef>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Locale independent conversion between numbers and text for the text
+   // formats. The format functions write into a buffer of at least bufferSize
+   // characters and return the end of the written text. Floating point values
+   // are written with the least number of digits that reads back to the same
+   // value. The parse functions return the position following the number, or 0
+   // if no valid number in range of the type starts at p.
+   class NumberFormat {
+   public:
+      static const std::size_t bufferSize = 32;
+
+      static char* format(char* out, long long val);
+      static char* format(char* out, unsigned long long val);
+      static char* format(char* out, double val);
+      static char* format(char* out, float val);
+
+      static const char* parse(const char* p, const char* end, long long& val);
+      static const char* parse(const char* p, const char* end, unsigned long long& val);
+      static const char* parse(const char* p, const char* end, double& val);
+      static const char* parse(const char* p, const char* end, float& val);
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // NUMBERFORMAT_H
@@ -34,6 +34,7 @@
 #include <ctrl/buffer/weakPtrWrapper.h>
 #include <ctrl/buffer/weakPtrWrapperImpl.h>
 #include <ctrl/idField.h>
+#include <ctrl/instrumentation.h>
 
 namespace ctrl {
 
@@ -49,6 +50,7 @@ namespace Private {
       }
 
       Shared_<void> get(const IdField& idField) const {
+         CTRL_INSTRUMENT_RESOLVED_POINTER();
          return m_ptrs.at(idField).first;
       }
 
@@ -78,6 +80,15 @@ namespace Private {
             iter->assign(voidPtr, sharedName);
       }
 
+      void clear() {
+         m_ptrs.clear();
+         m_delayed.clear();
+      }
+
+      std::size_t size() const {
+         return m_ptrs.size();
+      }
+
 
    private:
       std::unordered_map< IdField, std::pair<Shared_<void>, std::string> > m_ptrs;
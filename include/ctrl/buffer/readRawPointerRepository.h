@@ -44,6 +44,8 @@ namespace Private  {
       void* get(const IdField& i) const;
       std::string getTypeName(const IdField& i) const;
       void add(const IdField& i, void* p, const std::string& className);
+      void clear();
+      std::size_t size() const;
 
    private:
       std::unordered_map< IdField, std::pair<void*, std::string> > m_ptrs;
@@ -0,0 +1,72 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UTFCONVERTOR_H
+#define UTFCONVERTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Conversion between wide strings and UTF-8. Wide strings hold UTF-16 or
+   // UTF-32 depending on the size of wchar_t. Runs of ASCII characters are
+   // converted a block at a time; invalid sequences, like unpaired surrogates or
+   // malformed UTF-8, are skipped. The length functions return the exact number
+   // of units the matching conversion writes.
+   class UtfConvertor {
+   public:
+      static std::size_t utf8Length(const wchar_t* begin, const wchar_t* end);
+      static char* toUtf8(const wchar_t* begin, const wchar_t* end, char* out);
+
+      static std::size_t wideLength(const char* begin, const char* end);
+      static wchar_t* toWide(const char* begin, const char* end, wchar_t* out);
+
+      // Appends a single code point, as found in a character reference or an
+      // escape sequence. Returns false, leaving out unchanged, for surrogates
+      // and values above U+10FFFF.
+      static bool appendCodePoint(std::string& out, std::uint32_t code);
+
+      static void appendUtf8(std::string& out, const std::wstring& val) {
+         std::size_t begin = out.size();
+         out.resize(begin + utf8Length(val.data(), val.data() + val.length()));
+         toUtf8(val.data(), val.data() + val.length(), &out[0] + begin);
+      }
+
+      static void assignWide(std::wstring& out, const char* begin, const char* end) {
+         out.resize(wideLength(begin, end));
+         toWide(begin, end, &out[0]);
+      }
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // UTFCONVERTOR_H
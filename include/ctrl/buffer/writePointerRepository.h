@@ -27,6 +27,7 @@
 #ifndef WRITEPOINTERREPOSITORY_H
 #define WRITEPOINTERREPOSITORY_H
 
+#include <cstddef>
 #include <map>
 
 namespace ctrl {
@@ -46,6 +47,9 @@ namespace Private {
       int getReservedIndex(void* p);
       void clearReserved(void* p);
 
+      void clear();
+      std::size_t size() const;
+
    private:
       std::map< void*, int > m_indices;
       std::map< void*, int > m_reserved;
@@ -28,8 +28,7 @@
 #define XMLREADBUFFER_H
 
 #include <string>
-#include <stack>
-#include <sstream>
+#include <vector>
 #include <ctrl/buffer/abstractReadBuffer.h>
 #include <ctrl/buffer/bufferUtil.h>
 #include <ctrl/rapidxml/rapidxml.hpp>
@@ -40,8 +39,14 @@ namespace Private {
 
    class XmlReadBuffer : public ctrl::AbstractReadBuffer {
    public:
+      // Parses without modifying the data, names and values are referenced in
+      // place and entities are expanded when a value is read.
       XmlReadBuffer(const std::string& data);
 
+      // Parses the zero terminated data in place. The contents of the buffer are
+      // overwritten, but nothing has to be expanded when values are read.
+      XmlReadBuffer(char* data);
+
       virtual void enterObject(const Context& context) throw(Exception);
       virtual void enterMember(const Context& context, const char* suggested = 0) throw(Exception);
       virtual void leaveMember(const Context& context) throw(Exception);
@@ -82,48 +87,71 @@ namespace Private {
       virtual void read(double& val, const Context& context) throw(Exception);
       virtual void read(std::string& val, const Context& context) throw(Exception);
 
+      // When errors are recorded a missing node or attribute and an invalid
+      // character reference don't throw. The first error is kept and what is
+      // missing is read as an empty node, so the remaining reads finish quickly
+      // without unwinding the stack.
+      void recordErrors();
+      bool failed() const;
+      const std::string& errorReason() const;
+      std::size_t errorPosition() const;
+
    private:
+      // An element that is being read together with the child that is expected
+      // to be requested next. Children are normally requested in document order,
+      // so the cursor avoids scanning the sibling list from the start.
+      struct Level {
+         Level(rapidxml::xml_node<>* node_) : node(node_), cursor(node_->first_node()) {}
+
+         rapidxml::xml_node<>* node;
+         rapidxml::xml_node<>* cursor;
+      };
+
       std::string unwindStack();
-      void checkNonNull(const rapidxml::xml_base<>* node, const std::string& name);
+      void fail(const std::string& message) throw(Exception);
+      rapidxml::xml_node<>* checkNonNull(rapidxml::xml_node<>* node, const std::string& name);
+      rapidxml::xml_attribute<>* checkNonNull(rapidxml::xml_attribute<>* attr, const std::string& name);
+      rapidxml::xml_node<>* findChild(const char* name, std::size_t length);
+      rapidxml::xml_node<>* findChild(const std::string& name);
+      void enterChild(const std::string& name);
+
+      const std::string& readValue(const rapidxml::xml_base<>* node);
+      const std::string& readNodeOrAttributeValue(rapidxml::xml_node<>* node);
 
       template <class T_>
       void readNodeOrAttributeValue(rapidxml::xml_node<>* node, T_& val) {
          if (!m_skipNextFundamental) {
-            if (m_nextValueIsAttribute) {
-               val = m_util.fromString<T_>(node->first_attribute(m_attributeName.c_str())->value());
-            } else {
-               val = m_util.fromString<T_>(node->value());
-            }
+            const std::string& value = readNodeOrAttributeValue(node);
+            val = m_failed ? T_() : m_util.fromString<T_>(value);
          }
       }
 
       void readNodeOrAttributeValue(rapidxml::xml_node<>* node, std::string& val) {
          if (!m_skipNextFundamental) {
-            if (m_nextValueIsAttribute) {
-               val = node->first_attribute(m_attributeName.c_str())->value();
-            } else {
-               val =  node->value();
-            }
+            val = readNodeOrAttributeValue(node);
          }
       }
 
       void readNodeOrAttributeValue(rapidxml::xml_node<>* node, bool& val) {
          if (!m_skipNextFundamental) {
-            if (m_nextValueIsAttribute) {
-               val = std::string(node->first_attribute(m_attributeName.c_str())->value()) == "true" ? true : false;
-            } else {
-               val =  std::string(node->value()) == "true" ? true : false;
-            }
+            val = readNodeOrAttributeValue(node) == "true";
          }
       }
 
       BufferUtil m_util;
       rapidxml::xml_document<> m_document;
-      std::stack<rapidxml::xml_node<>*> m_stack;
+      std::vector<Level> m_stack;
       bool m_collectionStart;
       bool m_nextValueIsAttribute;
       bool m_skipNextFundamental;
+      bool m_inPlace;
+      bool m_recordErrors;
+      bool m_failed;
+      std::string m_errorReason;
+      rapidxml::xml_node<> m_missingNode;
+      rapidxml::xml_attribute<> m_missingAttribute;
       std::string m_attributeName;
+      std::string m_value;
    };
 
 } // namespace ctrl
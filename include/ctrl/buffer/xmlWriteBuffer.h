@@ -29,15 +29,17 @@
 
 #include <ctrl/buffer/abstractWriteBuffer.h>
 #include <ctrl/buffer/bufferUtil.h>
-#include <ctrl/rapidxml/rapidxml.hpp>
-#include <stack>
-#include <sstream>
+#include <vector>
 #include <string>
 
 namespace ctrl {
 
 namespace Private {
 
+   // Writes the XML text directly while the object graph is traversed. Open
+   // elements are tracked on a stack together with the offset at which their
+   // start tag ends, so attributes that arrive after a child element has been
+   // written are inserted there instead of requiring a document tree.
    class XmlWriteBuffer : public ctrl::AbstractWriteBuffer {
    public:
       XmlWriteBuffer(bool prettyPrint);
@@ -83,30 +85,60 @@ namespace Private {
       virtual void append(const double& val, const Context& context) throw(Exception);
       virtual void append(const std::string& val, const Context& context) throw(Exception);
 
-      std::string getOutput() const;
+      virtual void reset();
+
+      virtual std::size_t position() const;
+
+      const std::string& getOutput();
 
    private:
+      struct Element {
+         Element(std::size_t nameBegin_, std::size_t nameLength_, std::size_t tagEnd_)
+               : nameBegin(nameBegin_), nameLength(nameLength_), tagEnd(tagEnd_),
+                 startTagOpen(true), hasChildren(false) {}
+
+         std::size_t nameBegin;
+         std::size_t nameLength;
+         std::size_t tagEnd;
+         bool startTagOpen;
+         bool hasChildren;
+      };
+
       std::string unwindStack();
+      void openElement(const std::string& name);
+      void closeElement();
+      void closeStartTag(bool forChild);
+      void writeAttribute(const std::string& name, const std::string& val);
+      void writeText(const std::string& val);
+      void appendEscaped(std::string& out, const std::string& val);
+      void writeIndent(std::size_t depth);
 
       template <class T_>
-      void setNodeOrAttributeValue(rapidxml::xml_node<>* node, T_ val) {
+      void appendValue(const T_& val) {
+         if (!m_skipNextFundamental) {
+            appendValue(m_util.toString(val));
+         }
+      }
+
+      void appendValue(const std::string& val) {
          if (!m_skipNextFundamental) {
-            const char* str = m_document.allocate_string(m_util.toString(val).c_str());
             if (m_nextValueIsAttribute) {
-               node->append_attribute(m_document.allocate_attribute(m_attributeName, str));
+               writeAttribute(m_attributeName, val);
             } else {
-               node->value(str);
+               writeText(val);
             }
          }
       }
 
       BufferUtil m_util;
-      rapidxml::xml_document<> m_document;
-      std::stack<rapidxml::xml_node<>*> m_stack;
+      std::string m_output;
+      std::string m_names;
+      std::string m_escaped;
+      std::vector<Element> m_elements;
       bool m_collectionStart;
       bool m_nextValueIsAttribute;
       bool m_skipNextFundamental;
-      const char* m_attributeName;
+      std::string m_attributeName;
       bool m_prettyPrint;
    };
 
@@ -0,0 +1,160 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CACHED_H_
+#define CACHED_H_
+
+#include <memory>
+#include <ctrl/typemanip.h>
+#include <ctrl/buffer/abstractWriteBuffer.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   // The encoding of a value from the last time it was written, together with the
+   // version it was written for. Values that registered pointers while being
+   // encoded are never cached, since their pointer ids depend on what was
+   // written before them. Stored encodings are shrunk to their length, since
+   // the buffer reserves up to ten times what it holds while writing.
+   class EncodingCache {
+   public:
+      EncodingCache() : m_version(0), m_uncacheable(false) {}
+
+      bool isValid(const AbstractWriteBuffer& buffer, int version) const {
+         return m_encoding && m_version == version && buffer.isSameFormat(*m_encoding);
+      }
+
+      bool isUncacheable() const {
+         return m_uncacheable;
+      }
+
+      AbstractWriteBuffer& encoding() {
+         return *m_encoding;
+      }
+
+      void store(AbstractWriteBuffer* encoding, int version) {
+         encoding->shrinkToFit();
+         m_encoding.reset(encoding);
+         m_version = version;
+      }
+
+      void setUncacheable() {
+         m_encoding.reset();
+         m_uncacheable = true;
+      }
+
+      void clear() {
+         m_encoding.reset();
+         m_uncacheable = false;
+      }
+
+   private:
+      std::unique_ptr<AbstractWriteBuffer> m_encoding;
+      int m_version;
+      bool m_uncacheable;
+   };
+
+} // namespace Private
+
+   // Member wrapper that keeps the binary encoding of its value, so that writing
+   // an object again splices in the bytes of the parts that didn't change. Every
+   // change must go through set or mutate, or be followed by markDirty. Writing
+   // updates the cache, so the same object must not be written by two threads at
+   // once. Other formats write the value as if it wasn't wrapped.
+   template <class Value_>
+   class Cached {
+   public:
+      Cached() : m_value() {}
+      Cached(const Value_& value) : m_value(value) {}
+      Cached(const Cached& that) : m_value(that.m_value) {}
+
+      Cached& operator=(const Cached& that) {
+         set(that.m_value);
+         return *this;
+      }
+
+      Cached& operator=(const Value_& value) {
+         set(value);
+         return *this;
+      }
+
+      const Value_& get() const {
+         return m_value;
+      }
+
+      void set(const Value_& value) {
+         m_value = value;
+         markDirty();
+      }
+
+      // Marks the value dirty before handing it out, so keep the reference only
+      // for the change at hand.
+      Value_& mutate() {
+         markDirty();
+         return m_value;
+      }
+
+      void markDirty() {
+         m_cache.clear();
+      }
+
+      bool operator==(const Cached& that) const {
+         return m_value == that.m_value;
+      }
+
+      bool operator!=(const Cached& that) const {
+         return !(m_value == that.m_value);
+      }
+
+      Private::EncodingCache& encodingCache() const {
+         return m_cache;
+      }
+
+   private:
+      Value_ m_value;
+      mutable Private::EncodingCache m_cache;
+   };
+
+namespace Private {
+
+   template <class Value_>
+   struct IsFundamental<Cached<Value_>> { enum { value = IsFundamental<Value_>::value }; };
+
+   template <class Value_>
+   struct IsFloatingPoint<Cached<Value_>> { enum { value = IsFloatingPoint<Value_>::value }; };
+
+   template <class Value_>
+   struct IsCollection<Cached<Value_>> { enum { value = IsCollection<Value_>::value }; };
+
+   template <class Value_>
+   struct IsMap<Cached<Value_>> { enum { value = IsMap<Value_>::value, keyFundamental = IsMap<Value_>::keyFundamental }; };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // CACHED_H_
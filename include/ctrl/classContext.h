@@ -89,6 +89,14 @@ namespace Private {
 
    template <class ConcreteClass_>
    class ClassContextImpl : public AbstractClassContextImpl {
+   public:
+      // The implementation has no state, so one instance per class is shared by
+      // all contexts.
+      static const std::shared_ptr<AbstractClassContextImpl>& instance() {
+         static std::shared_ptr<AbstractClassContextImpl> impl(new ClassContextImpl<ConcreteClass_>());
+         return impl;
+      }
+
    private:
       template <class Root_, int i_>
       struct ClassContextSelector {
@@ -165,6 +173,11 @@ public:
 
    }
 
+   ClassContext(const std::shared_ptr<Private::AbstractClassContextImpl>& pimpl) : m_pimpl(pimpl),
+         m_singleRootPropertyRequested(false) {
+
+   }
+
    ClassContext(const ClassContext& that) : m_pimpl(that.m_pimpl),
          m_singleRootPropertyRequested(that.m_singleRootPropertyRequested) {
 
@@ -246,6 +259,10 @@ private:
       return m_singleRootPropertyRequested;
    }
 
+   bool hasMultipleRoots() const {
+      return m_pimpl.get() != 0 && !m_pimpl->hasSingleRoot();
+   }
+
    bool isSingleRootConflict(const std::type_info* type_info) const {
       if (m_pimpl.get() == 0) {
          return false;
@@ -33,11 +33,12 @@
 #include <ctrl/buffer/abstractWriteBuffer.h>
 #include <ctrl/typemanip.h>
 #include <ctrl/context.h>
+#include <ctrl/instrumentation.h>
+#include <ctrl/properties.h>
+#include <ctrl/holdsPointers.h>
 
 namespace ctrl {
 
-class WithVersion;
-
 namespace Private {
 
    template <class ConcreteClass_>
@@ -45,8 +46,10 @@ namespace Private {
    public:
       template <class Indices_>
       static void serialize(const ConcreteClass_& object, Indices_ indices, AbstractWriteBuffer& buffer, int version, const Context& context) {
-         Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
-         if (version >= memberContext.getOwningMember().getProperty<WithVersion>()) {
+         checkChunked(indices);
+         if (version >= ConcreteClass_::template CTRL_MemberVersion<Indices_::Head::value>::value) {
+            Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
+            CTRL_INSTRUMENT_MEMBER();
             buffer.enterMember(memberContext);
             ctrl::Private::serialize( object.* ConcreteClass_::CTRL_getMemberPtr(typename Indices_::Head()),
                                       buffer, version, memberContext );
@@ -61,8 +64,10 @@ namespace Private {
 
       template <class Indices_>
       static void deserialize(ConcreteClass_& object, Indices_ indices, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
-         Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
-         if (version >= memberContext.getOwningMember().getProperty<WithVersion>()) {
+         checkChunked(indices);
+         if (version >= ConcreteClass_::template CTRL_MemberVersion<Indices_::Head::value>::value) {
+            Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
+            CTRL_INSTRUMENT_MEMBER();
             buffer.enterMember(memberContext);
             ctrl::Private::deserialize( object.* ConcreteClass_::CTRL_getMemberPtr(typename Indices_::Head()),
                                         buffer, version, memberContext );
@@ -74,6 +79,15 @@ namespace Private {
       static void deserialize(ConcreteClass_& object, NullType indices, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
 
       }
+
+   private:
+      template <class Indices_>
+      static void checkChunked(Indices_) {
+         enum { index = Indices_::Head::value };
+         CheckChunkedMember< typename ConcreteClass_::template CTRL_MemberType<index>::Type,
+                             ConcreteClass_::template CTRL_HasProperty<Parallel, index>::value
+                             || ConcreteClass_::template CTRL_HasProperty<WithChunkIndex, index>::value >::check();
+      }
    };
 
 } // namespace Private
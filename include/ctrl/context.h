@@ -29,49 +29,101 @@
 
 #include <ctrl/memberContext.h>
 #include <ctrl/classContext.h>
-#include <memory>
-#include <set>
+#include <algorithm>
+#include <vector>
 
 namespace ctrl {
 
+namespace Private {
+
+   // Roots of which a single root property was used while traversing an object
+   // graph. A class with multiple roots that include one of them can't be
+   // traversed consistently any more. Usually there are only a few roots, so
+   // they are kept in a plain vector that is only allocated once one is added.
+   class SingleRoots {
+   public:
+      void add(const std::type_info* root) {
+         if (std::find(m_roots.begin(), m_roots.end(), root) == m_roots.end()) {
+            m_roots.push_back(root);
+         }
+      }
+
+      void add(const SingleRoots& that) {
+         for (std::vector<const std::type_info*>::const_iterator iter = that.m_roots.begin();
+              iter != that.m_roots.end(); ++iter) {
+            add(*iter);
+         }
+      }
+
+      bool empty() const {
+         return m_roots.empty();
+      }
+
+      std::vector<const std::type_info*>::const_iterator begin() const {
+         return m_roots.begin();
+      }
+
+      std::vector<const std::type_info*>::const_iterator end() const {
+         return m_roots.end();
+      }
+
+   private:
+      std::vector<const std::type_info*> m_roots;
+   };
+
+} // namespace Private
+
+// A context refers to the single roots of the top level context it was derived
+// from, so it must not outlive that context.
 class Context
 {
 public:
    Context(ClassContext classContext)
          : m_owningMember(0), m_classContext(classContext),
-         m_obligatedSingleRoots(new std::set<const std::type_info*>()) {
+         m_singleRoots(&m_ownSingleRoots) {
 
    }
 
    Context(const Context& that)
          : m_owningMember(that.m_owningMember),
          m_classContext(that.m_classContext),
-         m_obligatedSingleRoots(that.m_obligatedSingleRoots) {
+         m_singleRoots(that.m_singleRoots) {
 
    }
 
    Context(const Context& that, MemberContext owningMember)
          : m_owningMember(owningMember),
          m_classContext(that.m_classContext),
-         m_obligatedSingleRoots(that.m_obligatedSingleRoots) {
+         m_singleRoots(that.m_singleRoots) {
 
    }
 
    Context(const Context& that, ClassContext classContext)
          : m_owningMember(that.m_owningMember),
          m_classContext(classContext),
-         m_obligatedSingleRoots(that.m_obligatedSingleRoots) {
-      for (std::set<const std::type_info*>::const_iterator iter = m_obligatedSingleRoots->begin();
-           iter != m_obligatedSingleRoots->end(); ++iter) {
-         if (m_classContext.isSingleRootConflict(*iter)) {
-            throw Exception("Single root property requested for multiply inherited class: " + m_classContext.getName());
+         m_singleRoots(that.m_singleRoots) {
+      if (!m_singleRoots->empty() && m_classContext.hasMultipleRoots()) {
+         for (std::vector<const std::type_info*>::const_iterator iter = m_singleRoots->begin();
+              iter != m_singleRoots->end(); ++iter) {
+            if (m_classContext.isSingleRootConflict(*iter)) {
+               throw Exception("Single root property requested for multiply inherited class: " + m_classContext.getName());
+            }
          }
       }
    }
 
+   // Copy that collects its single roots in the given storage instead, for use
+   // on another thread. They are added back with merge once the thread is done.
+   Context(const Context& that, Private::SingleRoots& singleRoots)
+         : m_owningMember(that.m_owningMember),
+         m_classContext(that.m_classContext),
+         m_singleRoots(&singleRoots) {
+      singleRoots.add(*that.m_singleRoots);
+   }
+
    ~Context() {
       if (m_classContext.singleRootPropertyRequested()) {
-         m_obligatedSingleRoots->insert(m_classContext.getSingleRootId());
+         m_singleRoots->add(m_classContext.getSingleRootId());
       }
    }
 
@@ -83,11 +135,16 @@ public:
       return m_classContext;
    }
 
+   void merge(const Private::SingleRoots& singleRoots) const {
+      m_singleRoots->add(singleRoots);
+   }
+
 private:
    MemberContext m_owningMember;
    ClassContext m_classContext;
 
-   std::shared_ptr<std::set<const std::type_info*>> m_obligatedSingleRoots;
+   Private::SingleRoots m_ownSingleRoots;
+   Private::SingleRoots* m_singleRoots;
 };
 
 }
@@ -31,5 +31,6 @@
 #include <ctrl/properties.h>
 #include <ctrl/serialize.h>
 #include <ctrl/deserialize.h>
+#include <ctrl/delta.h>
 
 #endif // CTRL_H_
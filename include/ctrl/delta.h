@@ -0,0 +1,360 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DELTA_H_
+#define DELTA_H_
+
+#include <algorithm>
+#include <vector>
+#include <ctrl/serialize.h>
+#include <ctrl/deserialize.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   template <class T_>
+   struct IsReflected {
+      template <class U_>
+      static char test(typename U_::CTRL_MemberIndices*);
+
+      template <class U_>
+      static long test(...);
+
+      enum { value = sizeof(test<T_>(0)) == sizeof(char) };
+   };
+
+   // The patch being written, and two scratch buffers used to tell whether a
+   // value that is sent as a whole has changed, by comparing its encoding in the
+   // old and the new state.
+   struct DeltaBuffers {
+      DeltaBuffers(BinaryWriteBuffer& p, BinaryWriteBuffer& b, BinaryWriteBuffer& a)
+         : patch(p)
+         , before(b)
+         , after(a) {
+
+      }
+
+      BinaryWriteBuffer& patch;
+      BinaryWriteBuffer& before;
+      BinaryWriteBuffer& after;
+   };
+
+   template <class T_>
+   bool diffValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context);
+
+   template <class Element_, class Alloc_>
+   bool diffValue(const std::vector<Element_, Alloc_>& before, const std::vector<Element_, Alloc_>& after,
+                  DeltaBuffers& buffers, int version, const Context& context);
+
+   template <class Alloc_>
+   bool diffValue(const std::vector<bool, Alloc_>& before, const std::vector<bool, Alloc_>& after,
+                  DeltaBuffers& buffers, int version, const Context& context);
+
+   template <class T_>
+   void applyValue(T_& value, AbstractReadBuffer& patch, int version, const Context& context) throw(Exception);
+
+   template <class Element_, class Alloc_>
+   void applyValue(std::vector<Element_, Alloc_>& elements, AbstractReadBuffer& patch, int version,
+                   const Context& context) throw(Exception);
+
+   template <class Alloc_>
+   void applyValue(std::vector<bool, Alloc_>& elements, AbstractReadBuffer& patch, int version,
+                   const Context& context) throw(Exception);
+
+   // A reflected class is patched member by member. The base classes come first,
+   // each followed by the changed members of the class itself as their index plus
+   // one and their patch, and a zero.
+   template <class ConcreteClass_>
+   struct ClassDelta {
+      static bool diff(const ConcreteClass_& before, const ConcreteClass_& after, DeltaBuffers& buffers,
+                       int version, const Context& context) {
+         typedef typename ConcreteClass_::CTRL_BaseClasses BaseClasses;
+         bool changed = diffBases(before, after, BaseClasses(), buffers, version, context);
+
+         typedef typename ConcreteClass_::CTRL_MemberIndices Indices;
+         changed = diffMembers(before, after, Indices(), buffers, version, context) || changed;
+         buffers.patch.appendCollectionSize(0, context);
+         return changed;
+      }
+
+      static void apply(ConcreteClass_& value, AbstractReadBuffer& patch, int version, const Context& context) throw(Exception) {
+         typedef typename ConcreteClass_::CTRL_BaseClasses BaseClasses;
+         applyBases(value, BaseClasses(), patch, version, context);
+
+         typedef typename ConcreteClass_::CTRL_MemberIndices Indices;
+         std::size_t index;
+         patch.readCollectionSize(index, context);
+         for (; index != 0; patch.readCollectionSize(index, context)) {
+            applyMember(value, index - 1, Indices(), patch, version, context);
+         }
+         ConcreteClass_::initialize(value, version);
+      }
+
+   private:
+      template <class TList_>
+      static bool diffBases(const ConcreteClass_& before, const ConcreteClass_& after, TList_, DeltaBuffers& buffers,
+                            int version, const Context& context) {
+         typedef typename TList_::Head Base;
+         bool changed = ClassDelta<Base>::diff(dynamic_cast<const Base&>(before), dynamic_cast<const Base&>(after),
+                                               buffers, version, context);
+         return diffBases(before, after, typename TList_::Tail(), buffers, version, context) || changed;
+      }
+
+      static bool diffBases(const ConcreteClass_& before, const ConcreteClass_& after, NullType, DeltaBuffers& buffers,
+                            int version, const Context& context) {
+         return false;
+      }
+
+      template <class Indices_>
+      static bool diffMembers(const ConcreteClass_& before, const ConcreteClass_& after, Indices_, DeltaBuffers& buffers,
+                              int version, const Context& context) {
+         bool changed = false;
+         if (version >= ConcreteClass_::template CTRL_MemberVersion<Indices_::Head::value>::value) {
+            Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
+            long start = buffers.patch.length();
+            buffers.patch.appendCollectionSize(Indices_::Head::value + 1, memberContext);
+            buffers.patch.enterMember(memberContext);
+            changed = diffValue( before.* ConcreteClass_::CTRL_getMemberPtr(typename Indices_::Head()),
+                                 after.* ConcreteClass_::CTRL_getMemberPtr(typename Indices_::Head()),
+                                 buffers, version, memberContext );
+            buffers.patch.leaveMember(memberContext);
+            if (!changed)
+               buffers.patch.truncate(start);
+         }
+         return diffMembers(before, after, typename Indices_::Tail(), buffers, version, context) || changed;
+      }
+
+      static bool diffMembers(const ConcreteClass_& before, const ConcreteClass_& after, NullType, DeltaBuffers& buffers,
+                              int version, const Context& context) {
+         return false;
+      }
+
+      template <class TList_>
+      static void applyBases(ConcreteClass_& value, TList_, AbstractReadBuffer& patch, int version,
+                             const Context& context) throw(Exception) {
+         typedef typename TList_::Head Base;
+         ClassDelta<Base>::apply(dynamic_cast<Base&>(value), patch, version, context);
+         applyBases(value, typename TList_::Tail(), patch, version, context);
+      }
+
+      static void applyBases(ConcreteClass_& value, NullType, AbstractReadBuffer& patch, int version,
+                             const Context& context) throw(Exception) {
+
+      }
+
+      template <class Indices_>
+      static void applyMember(ConcreteClass_& value, std::size_t index, Indices_, AbstractReadBuffer& patch, int version,
+                              const Context& context) throw(Exception) {
+         if (index != static_cast<std::size_t>(Indices_::Head::value)) {
+            applyMember(value, index, typename Indices_::Tail(), patch, version, context);
+            return;
+         }
+         Context memberContext(context, MemberContext(new MemberContextImpl<ConcreteClass_, Indices_::Head::value>()));
+         patch.enterMember(memberContext);
+         applyValue(value.* ConcreteClass_::CTRL_getMemberPtr(typename Indices_::Head()), patch, version, memberContext);
+         patch.leaveMember(memberContext);
+      }
+
+      static void applyMember(ConcreteClass_& value, std::size_t index, NullType, AbstractReadBuffer& patch, int version,
+                              const Context& context) throw(Exception) {
+         throw Exception("Patch refers to an unknown member");
+      }
+   };
+
+   template <class T_>
+   bool sameValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context,
+                  Int2Type<true>) {
+      return before == after;
+   }
+
+   template <class T_>
+   bool sameValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context,
+                  Int2Type<false>) {
+      buffers.before.reset();
+      buffers.after.reset();
+      serialize(before, buffers.before, version, context);
+      serialize(after, buffers.after, version, context);
+      return buffers.before.length() == buffers.after.length()
+          && std::equal(buffers.before.data(), buffers.before.data() + buffers.before.length(), buffers.after.data());
+   }
+
+   template <class T_>
+   bool diffValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context,
+                  Int2Type<true>) {
+      return ClassDelta<T_>::diff(before, after, buffers, version, context);
+   }
+
+   // Anything that isn't a reflected class or a vector, including pointers, is
+   // sent whole when its encoding changed.
+   template <class T_>
+   bool diffValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context,
+                  Int2Type<false>) {
+      if (sameValue(before, after, buffers, version, context, Int2Type<IsFundamental<T_>::value>())) {
+         return false;
+      }
+      serialize(after, buffers.patch, version, context);
+      return true;
+   }
+
+   template <class T_>
+   bool diffValue(const T_& before, const T_& after, DeltaBuffers& buffers, int version, const Context& context) {
+      return diffValue(before, after, buffers, version, context, Int2Type<IsReflected<T_>::value>());
+   }
+
+   // A vector is patched with its new size, the changed elements it had before
+   // as their index plus one and their patch, a zero and the appended elements.
+   template <class Element_, class Alloc_>
+   bool diffValue(const std::vector<Element_, Alloc_>& before, const std::vector<Element_, Alloc_>& after,
+                  DeltaBuffers& buffers, int version, const Context& context) {
+      buffers.patch.appendCollectionSize(after.size(), context);
+      bool changed = before.size() != after.size();
+      std::size_t common = std::min(before.size(), after.size());
+      for (std::size_t i = 0; i < common; ++i) {
+         long start = buffers.patch.length();
+         buffers.patch.appendCollectionSize(i + 1, context);
+         if (diffValue(before[i], after[i], buffers, version, context)) {
+            changed = true;
+         } else {
+            buffers.patch.truncate(start);
+         }
+      }
+      buffers.patch.appendCollectionSize(0, context);
+      for (std::size_t i = common; i < after.size(); ++i) {
+         serialize(after[i], buffers.patch, version, context);
+      }
+      return changed;
+   }
+
+   template <class Alloc_>
+   bool diffValue(const std::vector<bool, Alloc_>& before, const std::vector<bool, Alloc_>& after,
+                  DeltaBuffers& buffers, int version, const Context& context) {
+      return diffValue(before, after, buffers, version, context, Int2Type<false>());
+   }
+
+   template <class T_>
+   void applyValue(T_& value, AbstractReadBuffer& patch, int version, const Context& context, Int2Type<true>) throw(Exception) {
+      ClassDelta<T_>::apply(value, patch, version, context);
+   }
+
+   template <class T_>
+   void applyValue(T_& value, AbstractReadBuffer& patch, int version, const Context& context, Int2Type<false>) throw(Exception) {
+      deserialize(value, patch, version, context);
+   }
+
+   template <class T_>
+   void applyValue(T_& value, AbstractReadBuffer& patch, int version, const Context& context) throw(Exception) {
+      applyValue(value, patch, version, context, Int2Type<IsReflected<T_>::value>());
+   }
+
+   template <class Element_, class Alloc_>
+   void applyValue(std::vector<Element_, Alloc_>& elements, AbstractReadBuffer& patch, int version,
+                   const Context& context) throw(Exception) {
+      std::size_t size;
+      patch.readCollectionSize(size, context);
+      patch.checkCollectionSize(size, sizeof(Element_));
+      // Only the elements beyond the old size are written whole.
+      std::size_t common = std::min(size, elements.size());
+      std::size_t added = size - common;
+      patch.checkEncodedSize(added, MinEncodedSize<Element_>::value);
+      size = common + added;
+      std::size_t index;
+      patch.readCollectionSize(index, context);
+      for (; index != 0; patch.readCollectionSize(index, context)) {
+         if (index > common)
+            throw Exception("Patch refers to an unknown element");
+         applyValue(elements[index - 1], patch, version, context);
+      }
+      elements.resize(size);
+      for (std::size_t i = common; i < size; ++i) {
+         deserialize(elements[i], patch, version, context);
+      }
+   }
+
+   template <class Alloc_>
+   void applyValue(std::vector<bool, Alloc_>& elements, AbstractReadBuffer& patch, int version,
+                   const Context& context) throw(Exception) {
+      deserialize(elements, patch, version, context);
+   }
+
+} // namespace Private
+
+// Writes the changes between two states of an object as a binary patch, to be
+// applied to a copy of the old state with applyPatch. Reflected classes and
+// vectors are compared member by member and element by element; any other
+// member that changed, pointers included, is written whole. A changed pointer
+// is read back as a new object, so on the receiving side it no longer shares
+// its target with members the patch doesn't mention.
+template <int alignment_, int endian_, class ConcreteClass_>
+char* diff(const ConcreteClass_& before, const ConcreteClass_& after, long& length, int version = 1) {
+   Private::BinaryWriteBuffer patch(new Private::BinaryWriteBufferImpl<alignment_, endian_>());
+   Private::BinaryWriteBuffer beforeScratch(new Private::BinaryWriteBufferImpl<alignment_, endian_>());
+   Private::BinaryWriteBuffer afterScratch(new Private::BinaryWriteBufferImpl<alignment_, endian_>());
+   Private::DeltaBuffers buffers(patch, beforeScratch, afterScratch);
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
+   patch.appendVersion(version, context);
+   Private::diffValue(before, after, buffers, version, context);
+   length = patch.length();
+   return patch.getData();
+}
+
+template <int alignment_, class ConcreteClass_>
+char* diff(const ConcreteClass_& before, const ConcreteClass_& after, long& length, int version = 1) {
+   return diff<alignment_, CTRL_BYTE_ORDER, ConcreteClass_>(before, after, length, version);
+}
+
+template <class ConcreteClass_>
+char* diff(const ConcreteClass_& before, const ConcreteClass_& after, long& length, int version = 1) {
+   return diff<CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER, ConcreteClass_>(before, after, length, version);
+}
+
+template <class ConcreteClass_, int alignment_, int endian_>
+void applyPatch(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
+   int dataVersion;
+   buffer.readVersion(dataVersion, context);
+   if (dataVersion != version)
+      throw Exception("applyPatch: version mismatch");
+   Private::applyValue(obj, buffer, version, context);
+   if (!buffer.reachedEnd()) {
+      throw Exception("Input data is corrupt");
+   }
+}
+
+template <class ConcreteClass_, int alignment_>
+void applyPatch(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   applyPatch<ConcreteClass_, alignment_, CTRL_BYTE_ORDER>(obj, bytes, length, version);
+}
+
+template <class ConcreteClass_>
+void applyPatch(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   applyPatch<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(obj, bytes, length, version);
+}
+
+} // namespace ctrl
+
+#endif // DELTA_H_
@@ -27,7 +27,10 @@
 #ifndef DESERIALIZE_H_
 #define DESERIALIZE_H_
 
-#include <boost/locale.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
 #include <ctrl/forwardDeserialize.h>
 #include <ctrl/classSerializer.h>
 #include <ctrl/baseClassSerializer.h>
@@ -35,31 +38,58 @@
 #include <ctrl/buffer/binaryReadBufferImpl.h>
 #include <ctrl/buffer/xmlReadBuffer.h>
 #include <ctrl/buffer/jsonReadBuffer.h>
+#include <ctrl/buffer/bitPacking.h>
 #include <ctrl/platformFormat.h>
+#include <ctrl/adaptorContainer.h>
+#include <ctrl/arena.h>
+#include <ctrl/minEncodedSize.h>
+#include <ctrl/cached.h>
+#include <ctrl/parallelChunks.h>
+#include <ctrl/instrumentation.h>
 #include <ctrl/exception.h>
 #include <ctrl/context.h>
 
 namespace ctrl {
 
+template <class ConcreteClass_>
+void fromReadBufferInto(ConcreteClass_& obj, AbstractReadBuffer& buffer, int version) throw(Exception) {
+   CTRL_INSTRUMENT_CALL(ConcreteClass_, buffer);
+   int dataVersion;
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
+   buffer.readVersion(dataVersion, context);
+   if (dataVersion != version)
+      throw Exception("deserialize: version mismatch");
+   Private::deserialize(obj, buffer, version, context);
+   buffer.leaveRoot();
+}
+
 template <class ConcreteClass_>
 ConcreteClass_* fromReadBuffer(AbstractReadBuffer& buffer, int version) throw(Exception) {
-   ConcreteClass_* ptr;
+   ConcreteClass_* ptr = 0;
    try {
       ptr = new ConcreteClass_();
-      int dataVersion;
-      Context context(ClassContext(new Private::ClassContextImpl<ConcreteClass_>()));
-      buffer.readVersion(dataVersion, context);
-      if (dataVersion != version)
-         throw Exception("deserialize: version mismatch");
-      Private::deserialize(*ptr, buffer, version, context);
+      fromReadBufferInto(*ptr, buffer, version);
       return ptr;
    }
    catch(...) { delete ptr; throw; }
 }
 
+template <class ConcreteClass_>
+ConcreteClass_* fromReadBuffer(AbstractReadBuffer& buffer, Arena& arena, int version) throw(Exception) {
+   ArenaScope scope(arena);
+   std::size_t destructors = arena.destructorCount();
+   try {
+      ConcreteClass_* ptr = Private::createObject<ConcreteClass_>();
+      fromReadBufferInto(*ptr, buffer, version);
+      return ptr;
+   }
+   catch(...) { arena.runDestructors(destructors); throw; }
+}
+
 template <class ConcreteClass_, int alignment_, int endian_>
-ConcreteClass_* fromBinary(const char* bytes, const long& length, int version = 1) throw(Exception) {
+ConcreteClass_* fromBinary(const char* bytes, const long& length, const Limits& limits, int version = 1) throw(Exception) {
    Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+   buffer.setLimits(limits);
    ConcreteClass_* ptr = fromReadBuffer<ConcreteClass_>(buffer, version);
    if (!buffer.reachedEnd()) {
       delete ptr;
@@ -68,6 +98,11 @@ ConcreteClass_* fromBinary(const char* bytes, const long& length, int version =
    return ptr;
 }
 
+template <class ConcreteClass_, int alignment_, int endian_>
+ConcreteClass_* fromBinary(const char* bytes, const long& length, int version = 1) throw(Exception) {
+   return fromBinary<ConcreteClass_, alignment_, endian_>(bytes, length, Limits(), version);
+}
+
 template <class ConcreteClass_, int alignment_>
 ConcreteClass_* fromBinary(const char* bytes, const long& length, int version = 1) throw(Exception) {
    return fromBinary<ConcreteClass_, alignment_, CTRL_BYTE_ORDER>(bytes, length, version);
@@ -78,22 +113,427 @@ ConcreteClass_* fromBinary(const char* bytes, const long& length, int version =
    return fromBinary<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(bytes, length, version);
 }
 
+template <class ConcreteClass_>
+ConcreteClass_* fromBinary(const char* bytes, const long& length, const Limits& limits, int version = 1) throw(Exception) {
+   return fromBinary<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(bytes, length, limits, version);
+}
+
+template <class ConcreteClass_>
+ConcreteClass_* fromBinary(const char* bytes, const long& length, Arena& arena, int version = 1) throw(Exception) {
+   Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(bytes, length));
+   std::size_t destructors = arena.destructorCount();
+   ConcreteClass_* ptr = fromReadBuffer<ConcreteClass_>(buffer, arena, version);
+   if (!buffer.reachedEnd()) {
+      arena.runDestructors(destructors);
+      throw Exception("Input data is corrupt");
+   }
+   return ptr;
+}
+
+template <class ConcreteClass_, int alignment_, int endian_>
+void fromBinaryInto(ConcreteClass_& obj, const char* bytes, const long& length, const Limits& limits,
+                    int version = 1) throw(Exception) {
+   Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+   buffer.setLimits(limits);
+   fromReadBufferInto(obj, buffer, version);
+   if (!buffer.reachedEnd()) {
+      throw Exception("Input data is corrupt");
+   }
+}
+
+template <class ConcreteClass_, int alignment_, int endian_>
+void fromBinaryInto(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   fromBinaryInto<ConcreteClass_, alignment_, endian_>(obj, bytes, length, Limits(), version);
+}
+
+template <class ConcreteClass_, int alignment_>
+void fromBinaryInto(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   fromBinaryInto<ConcreteClass_, alignment_, CTRL_BYTE_ORDER>(obj, bytes, length, version);
+}
+
+template <class ConcreteClass_>
+void fromBinaryInto(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+   fromBinaryInto<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(obj, bytes, length, version);
+}
+
+template <class ConcreteClass_>
+void fromBinaryInto(ConcreteClass_& obj, const char* bytes, const long& length, const Limits& limits,
+                    int version = 1) throw(Exception) {
+   fromBinaryInto<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(obj, bytes, length, limits, version);
+}
+
+template <class ConcreteClass_, int alignment_, int endian_, class OutputIterator_>
+OutputIterator_ fromBinaryBatch(const char* bytes, const long& length, OutputIterator_ out, const Limits& limits,
+                                int version = 1) throw(Exception) {
+   Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+   buffer.setLimits(limits);
+   CTRL_INSTRUMENT_CALL(ConcreteClass_, buffer);
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
+   int dataVersion;
+   buffer.readVersion(dataVersion, context);
+   if (dataVersion != version)
+      throw Exception("deserialize: version mismatch");
+
+   std::size_t count;
+   buffer.readCollectionSize(count, context);
+   buffer.checkEncodedSize(count, sizeof(std::size_t));
+   buffer.checkCollectionSize(count, sizeof(ConcreteClass_));
+   for (std::size_t i = 0; i < count; ++i) {
+      std::size_t size;
+      buffer.readCollectionSize(size, context);
+      if (size > buffer.remaining())
+         throw Exception("Input data is corrupt");
+      std::size_t end = buffer.remaining() - size;
+
+      ConcreteClass_ obj;
+      buffer.clearPointerRepositories();
+      Private::deserialize(obj, buffer, version, context);
+      if (buffer.remaining() != end)
+         throw Exception("Input data is corrupt");
+      *out = std::move(obj);
+      ++out;
+   }
+   if (!buffer.reachedEnd())
+      throw Exception("Input data is corrupt");
+   return out;
+}
+
+template <class ConcreteClass_, int alignment_, int endian_, class OutputIterator_>
+OutputIterator_ fromBinaryBatch(const char* bytes, const long& length, OutputIterator_ out, int version = 1) throw(Exception) {
+   return fromBinaryBatch<ConcreteClass_, alignment_, endian_, OutputIterator_>(bytes, length, out, Limits(), version);
+}
+
+template <class ConcreteClass_, int alignment_, class OutputIterator_>
+OutputIterator_ fromBinaryBatch(const char* bytes, const long& length, OutputIterator_ out, int version = 1) throw(Exception) {
+   return fromBinaryBatch<ConcreteClass_, alignment_, CTRL_BYTE_ORDER, OutputIterator_>(bytes, length, out, version);
+}
+
+template <class ConcreteClass_, class OutputIterator_>
+OutputIterator_ fromBinaryBatch(const char* bytes, const long& length, OutputIterator_ out, int version = 1) throw(Exception) {
+   return fromBinaryBatch<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER, OutputIterator_>(bytes, length, out, version);
+}
+
+template <class ConcreteClass_, class OutputIterator_>
+OutputIterator_ fromBinaryBatch(const char* bytes, const long& length, OutputIterator_ out, const Limits& limits,
+                                int version = 1) throw(Exception) {
+   return fromBinaryBatch<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER, OutputIterator_>(bytes, length, out,
+                                                                                                  limits, version);
+}
+
 template <class ConcreteClass_>
 ConcreteClass_* fromXml(const std::string& data, int version = 1) throw(Exception) {
    Private::XmlReadBuffer buffer(data);
    return fromReadBuffer<ConcreteClass_>(buffer, version);
 }
 
+template <class ConcreteClass_>
+ConcreteClass_* fromXmlInPlace(char* data, int version = 1) throw(Exception) {
+   Private::XmlReadBuffer buffer(data);
+   return fromReadBuffer<ConcreteClass_>(buffer, version);
+}
+
+template <class ConcreteClass_>
+ConcreteClass_* fromXml(const std::string& data, Arena& arena, int version = 1) throw(Exception) {
+   Private::XmlReadBuffer buffer(data);
+   return fromReadBuffer<ConcreteClass_>(buffer, arena, version);
+}
+
+template <class ConcreteClass_>
+ConcreteClass_* fromXml(const std::string& data, const Limits& limits, int version = 1) throw(Exception) {
+   Private::XmlReadBuffer buffer(data);
+   buffer.setLimits(limits);
+   return fromReadBuffer<ConcreteClass_>(buffer, version);
+}
+
+template <class ConcreteClass_>
+void fromXmlInto(ConcreteClass_& obj, const std::string& data, int version = 1) throw(Exception) {
+   Private::XmlReadBuffer buffer(data);
+   fromReadBufferInto(obj, buffer, version);
+}
+
+template <class ConcreteClass_>
+void fromXmlInto(ConcreteClass_& obj, const std::string& data, const Limits& limits, int version = 1) throw(Exception) {
+   Private::XmlReadBuffer buffer(data);
+   buffer.setLimits(limits);
+   fromReadBufferInto(obj, buffer, version);
+}
+
 template <class ConcreteClass_>
 ConcreteClass_* fromJson(const std::string& data) throw(Exception) {
    Private::JsonReadBuffer buffer(data);
    return fromReadBuffer<ConcreteClass_>(buffer, 1);
 }
 
+template <class ConcreteClass_>
+ConcreteClass_* fromJson(const std::string& data, Arena& arena) throw(Exception) {
+   Private::JsonReadBuffer buffer(data);
+   return fromReadBuffer<ConcreteClass_>(buffer, arena, 1);
+}
+
+template <class ConcreteClass_>
+ConcreteClass_* fromJson(const std::string& data, const Limits& limits) throw(Exception) {
+   Private::JsonReadBuffer buffer(data);
+   buffer.setLimits(limits);
+   return fromReadBuffer<ConcreteClass_>(buffer, 1);
+}
+
+template <class ConcreteClass_>
+void fromJsonInto(ConcreteClass_& obj, const std::string& data) throw(Exception) {
+   Private::JsonReadBuffer buffer(data);
+   fromReadBufferInto(obj, buffer, 1);
+}
+
+template <class ConcreteClass_>
+void fromJsonInto(ConcreteClass_& obj, const std::string& data, const Limits& limits) throw(Exception) {
+   Private::JsonReadBuffer buffer(data);
+   buffer.setLimits(limits);
+   fromReadBufferInto(obj, buffer, 1);
+}
+
+// Reads the messages of a BinaryWriteSession in the order they were written.
+// Objects behind pointers are kept from one message to the next, so a later
+// message can refer to them. Only shared pointers keep their targets alive:
+// a raw pointer in a later message points into the message that first held
+// its target, so that message must outlive the later ones until the session
+// is reset. After a message failed to read, both sessions must be reset.
+template <int alignment_ = CTRL_MEMORY_ALIGNMENT, int endian_ = CTRL_BYTE_ORDER>
+class BinaryReadSession {
+public:
+   BinaryReadSession() : m_buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(0, 0)) {}
+
+   template <class ConcreteClass_>
+   ConcreteClass_* read(const char* bytes, const long& length, int version = 1) throw(Exception) {
+      ConcreteClass_* ptr = 0;
+      try {
+         ptr = new ConcreteClass_();
+         readInto(*ptr, bytes, length, version);
+         return ptr;
+      }
+      catch(...) { delete ptr; throw; }
+   }
+
+   template <class ConcreteClass_>
+   void readInto(ConcreteClass_& obj, const char* bytes, const long& length, int version = 1) throw(Exception) {
+      m_buffer.setInput(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+      m_buffer.resetLimitCounters();
+      fromReadBufferInto(obj, m_buffer, version);
+      if (!m_buffer.reachedEnd()) {
+         throw Exception("Input data is corrupt");
+      }
+   }
+
+   // The limits apply to every message on its own.
+   void setLimits(const Limits& limits) {
+      m_buffer.setLimits(limits);
+   }
+
+   // Forgets the objects read so far, to follow a reset of the writing session.
+   void reset() {
+      m_buffer.clearPointerRepositories();
+   }
+
+private:
+   BinaryReadSession(const BinaryReadSession&);
+   BinaryReadSession& operator=(const BinaryReadSession&);
+
+   Private::BinaryReadBuffer m_buffer;
+};
+
+// Result of the tryFrom functions, which report invalid input instead of
+// throwing. On failure object is null, reason describes the first error and
+// position is its offset in the input, or Exception::unknownPosition if the
+// reader can't tell.
+template <class ConcreteClass_>
+struct ReadResult {
+   ReadResult() : position(Exception::unknownPosition) { }
+
+   explicit operator bool() const { return object.get() != 0; }
+
+   std::unique_ptr<ConcreteClass_> object;
+   std::string reason;
+   std::size_t position;
+};
+
+namespace Private {
+
+   template <class ConcreteClass_>
+   void setError(ReadResult<ConcreteClass_>& result, const std::string& reason, std::size_t position) {
+      result.object.reset();
+      result.reason = reason;
+      result.position = position;
+   }
+
+} // namespace Private
+
+// Binary input that ends too early, the most common kind of damage, is handled
+// without throwing: the reader records the position and winds down. Other
+// errors are caught and reported the same way.
+template <class ConcreteClass_, int alignment_, int endian_>
+ReadResult<ConcreteClass_> tryFromBinary(const char* bytes, const long& length, const Limits& limits, int version = 1) {
+   ReadResult<ConcreteClass_> result;
+   Private::BinaryReadBuffer buffer(new Private::BinaryReadBufferImpl<alignment_, endian_>(bytes, length));
+   buffer.recordErrors();
+   buffer.setLimits(limits);
+   try {
+      CTRL_INSTRUMENT_CALL(ConcreteClass_, buffer);
+      Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
+      int dataVersion;
+      buffer.readVersion(dataVersion, context);
+      if (buffer.failed()) {
+         Private::setError(result, "Input data is truncated", buffer.errorPosition());
+      } else if (dataVersion != version) {
+         Private::setError(result, "deserialize: version mismatch", 0);
+      } else {
+         result.object.reset(new ConcreteClass_());
+         Private::deserialize(*result.object, buffer, version, context);
+         if (buffer.failed()) {
+            Private::setError(result, "Input data is truncated", buffer.errorPosition());
+         } else if (!buffer.reachedEnd()) {
+            Private::setError(result, "Input data is corrupt", length - buffer.remaining());
+         }
+      }
+   }
+   catch (Exception& e) {
+      Private::setError(result, e.what(), e.position() != Exception::unknownPosition ? e.position()
+                                                                                    : length - buffer.remaining());
+   }
+   catch (std::exception& e) {
+      Private::setError(result, e.what(), length - buffer.remaining());
+   }
+   return result;
+}
+
+template <class ConcreteClass_, int alignment_, int endian_>
+ReadResult<ConcreteClass_> tryFromBinary(const char* bytes, const long& length, int version = 1) {
+   return tryFromBinary<ConcreteClass_, alignment_, endian_>(bytes, length, Limits(), version);
+}
+
+template <class ConcreteClass_, int alignment_>
+ReadResult<ConcreteClass_> tryFromBinary(const char* bytes, const long& length, int version = 1) {
+   return tryFromBinary<ConcreteClass_, alignment_, CTRL_BYTE_ORDER>(bytes, length, version);
+}
+
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromBinary(const char* bytes, const long& length, int version = 1) {
+   return tryFromBinary<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(bytes, length, version);
+}
+
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromBinary(const char* bytes, const long& length, const Limits& limits, int version = 1) {
+   return tryFromBinary<ConcreteClass_, CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER>(bytes, length, limits, version);
+}
+
 namespace Private {
 
+   // Reads with a text buffer that records its errors. What is thrown after the
+   // first recorded error is a consequence of it, so the recorded one is
+   // reported instead.
+   template <class ConcreteClass_, class Buffer_>
+   void readRecordingErrors(ReadResult<ConcreteClass_>& result, Buffer_& buffer, int version) {
+      try {
+         result.object.reset(fromReadBuffer<ConcreteClass_>(buffer, version));
+         if (!buffer.failed()) {
+            return;
+         }
+      }
+      catch (Exception& e) {
+         if (!buffer.failed()) {
+            setError(result, e.what(), e.position());
+            return;
+         }
+      }
+      catch (std::exception& e) {
+         if (!buffer.failed()) {
+            setError(result, e.what(), Exception::unknownPosition);
+            return;
+         }
+      }
+      setError(result, buffer.errorReason(), buffer.errorPosition());
+   }
+
+} // namespace Private
+
+// Syntax errors, missing members and invalid character references are recorded
+// by the readers without throwing. XML that doesn't parse and a JSON root that
+// is null are still thrown when the buffer is created, and other errors are
+// caught and reported the same way.
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromXml(const std::string& data, const Limits& limits, int version = 1) {
+   ReadResult<ConcreteClass_> result;
+   try {
+      Private::XmlReadBuffer buffer(data);
+      buffer.recordErrors();
+      buffer.setLimits(limits);
+      Private::readRecordingErrors(result, buffer, version);
+   }
+   catch (Exception& e) {
+      Private::setError(result, e.what(), e.position());
+   }
+   catch (std::exception& e) {
+      Private::setError(result, e.what(), Exception::unknownPosition);
+   }
+   return result;
+}
+
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromXml(const std::string& data, int version = 1) {
+   return tryFromXml<ConcreteClass_>(data, Limits(), version);
+}
+
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromJson(const std::string& data, const Limits& limits) {
+   ReadResult<ConcreteClass_> result;
+   try {
+      Private::JsonReadBuffer buffer(data);
+      buffer.recordErrors();
+      buffer.setLimits(limits);
+      Private::readRecordingErrors(result, buffer, 1);
+   }
+   catch (Exception& e) {
+      Private::setError(result, e.what(), e.position());
+   }
+   catch (std::exception& e) {
+      Private::setError(result, e.what(), Exception::unknownPosition);
+   }
+   return result;
+}
+
+template <class ConcreteClass_>
+ReadResult<ConcreteClass_> tryFromJson(const std::string& data) {
+   return tryFromJson<ConcreteClass_>(data, Limits());
+}
+
+namespace Private {
+
+   class NestingGuard {
+   public:
+      NestingGuard(AbstractReadBuffer& buffer) : m_buffer(buffer) {
+         m_buffer.enterNesting();
+      }
+
+      ~NestingGuard() {
+         m_buffer.leaveNesting();
+      }
+
+   private:
+      NestingGuard(const NestingGuard&);
+      NestingGuard& operator=(const NestingGuard&);
+
+      AbstractReadBuffer& m_buffer;
+   };
+
+   template <class Container_>
+   void readCollectionSize(const Container_& elements, std::size_t& size, AbstractReadBuffer& buffer,
+                           const Context& context) throw(Exception) {
+      buffer.readCollectionSize(size, context);
+      buffer.checkEncodedSize(size, MinEncodedSize<typename Container_::value_type>::value);
+      buffer.checkCollectionSize(size, sizeof(typename Container_::value_type));
+   }
+
    template <class ConcreteClass_>
    void deserialize(ConcreteClass_& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+      CTRL_INSTRUMENT_OBJECT(ConcreteClass_);
+      NestingGuard nesting(buffer);
       buffer.enterObject(context);
       typedef typename ConcreteClass_::CTRL_BaseClasses TList;
       BaseClassSerializer<ConcreteClass_>::deserialize(value, TList(), buffer, version, context);
@@ -106,33 +546,96 @@ namespace Private {
 
    template <size_t size_>
    void deserialize(std::bitset<size_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
-      size_t nbChars = size_ / 8 + (size_ % 8 == 0 ? 0 : 1);
-      char* bits = new char[nbChars];
-      buffer.readBits(bits, size_, context);
+      std::vector<char> bits(BitPacking::nbChars(size_));
+      buffer.readBits(bits.data(), size_, context);
+      BitPacking::unpack(bits.data(), elements);
+   }
+
+   typedef std::vector<std::unique_ptr<AbstractReadBuffer>> ReadParts;
+
+   // Reads the chunk index in front of the elements of a large collection that
+   // was written with CTRL_WITH_CHUNK_INDEX, and returns a buffer for every chunk
+   // together with the offset of its first element. No parts are returned when
+   // the collection has no index. A chunk can't claim more elements than its
+   // length holds, so a corrupt index can't make the caller allocate more
+   // elements than the input could contain.
+   inline void readChunkIndex(std::size_t size, std::size_t minElementSize, AbstractReadBuffer& buffer,
+                              const Context& context, std::vector<std::size_t>& offsets, ReadParts& parts) throw(Exception) {
+      if (!ParallelChunks::indexed(size, context) || !buffer.hasParts()) {
+         return;
+      }
+      std::size_t nbChunks;
+      buffer.readCollectionSize(nbChunks, context);
+      if (nbChunks == 0 || nbChunks > ParallelChunks::maxIndexedChunks)
+         throw Exception("Input data is corrupt");
+
+      std::vector<std::size_t> lengths;
+      offsets.push_back(0);
+      for (std::size_t i = 0; i < nbChunks; ++i) {
+         std::size_t count, length;
+         buffer.readCollectionSize(count, context);
+         buffer.readCollectionSize(length, context);
+         if (count > size - offsets.back() || (minElementSize != 0 && count > length / minElementSize))
+            throw Exception("Input data is corrupt");
+         offsets.push_back(offsets.back() + count);
+         lengths.push_back(length);
+      }
+      if (offsets.back() != size)
+         throw Exception("Input data is corrupt");
+      for (std::size_t i = 0; i < nbChunks; ++i) {
+         parts.push_back(std::unique_ptr<AbstractReadBuffer>(buffer.readPart(lengths[i])));
+      }
+   }
 
-      unsigned char mask = 0x80;
-      for (size_t i = 0; i < size_; ++i) {
-         if ((bits[i / 8] & mask) != 0)
-            elements.set(i);
-         if (mask == 0x01)
-            mask = 0x80;
-         else
-            mask = mask >> 1;
+   // Reads the chunks of an indexed collection into storage that already has
+   // the right size, on as many threads as CTRL_PARALLEL allows. Allocations
+   // from an arena aren't thread safe, so reading into an arena stays on the
+   // calling thread, as does reading a collection nested in a chunk.
+   template <class Iterator_>
+   void deserializeChunks(Iterator_ first, const std::vector<std::size_t>& offsets, ReadParts& parts,
+                          AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+      std::vector<SingleRoots> singleRoots(parts.size());
+      std::vector<Context> contexts;
+      for (std::size_t i = 0; i < parts.size(); ++i) {
+         contexts.push_back(Context(context, singleRoots[i]));
+      }
+      std::size_t threads = Arena::current() == 0 && !buffer.isPart() ? ParallelChunks::threads(context) : 1;
+      ParallelChunks::run(parts.size(), threads, [&](std::size_t chunk) {
+         Iterator_ end = first + offsets[chunk + 1];
+         for (Iterator_ iter = first + offsets[chunk]; iter != end; ++iter) {
+            parts[chunk]->nextCollectionElement(contexts[chunk]);
+            deserialize(*iter, *parts[chunk], version, contexts[chunk]);
+         }
+         parts[chunk]->leavePart();
+      });
+      for (std::size_t i = 0; i < parts.size(); ++i) {
+         context.merge(singleRoots[i]);
+         buffer.addPartAllocations(*parts[i]);
       }
-	  delete[] bits;
    }
 
    template <class Element_, class Alloc_>
    void deserialize(std::deque<Element_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::deque<Element_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      std::vector<std::size_t> offsets;
+      ReadParts parts;
+      readChunkIndex(size, MinEncodedSize<Element_>::value, buffer, context, offsets, parts);
+      if (!parts.empty()) {
+         elements.resize(size);
+         deserializeChunks(elements.begin(), offsets, parts, buffer, version, context);
+         buffer.leaveCollection(context);
+         return;
+      }
       for (typename std::deque<Element_, Alloc_>::size_type i = 0; i < size; ++i) {
-         Element_ el;
+         if (i == elements.size())
+            elements.emplace_back();
          buffer.nextCollectionElement(context);
-         deserialize(el, buffer, version, context);
-         elements.push_back(std::move(el));
+         deserialize(elements[i], buffer, version, context);
       }
+      if (elements.size() > size)
+         elements.erase(elements.begin() + size, elements.end());
       buffer.leaveCollection(context);
    }
 
@@ -140,13 +643,15 @@ namespace Private {
    void deserialize(std::list<Element_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::list<Element_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      for (typename std::list<Element_, Alloc_>::size_type i = 0; i < size; ++i) {
-         Element_ el;
+      readCollectionSize(elements, size, buffer, context);
+      typename std::list<Element_, Alloc_>::iterator iter = elements.begin();
+      for (typename std::list<Element_, Alloc_>::size_type i = 0; i < size; ++i, ++iter) {
+         if (iter == elements.end())
+            iter = elements.emplace(iter);
          buffer.nextCollectionElement(context);
-         deserialize(el, buffer, version, context);
-         elements.push_back(std::move(el));
+         deserialize(*iter, buffer, version, context);
       }
+      elements.erase(iter, elements.end());
       buffer.leaveCollection(context);
    }
 
@@ -154,18 +659,19 @@ namespace Private {
    void deserialize(std::map<Key_, Value_, Comp_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::map<Key_, Value_, Comp_, Alloc_>::size_type size;
       buffer.enterMap(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
       for (typename std::map<Key_, Value_, Comp_, Alloc_>::size_type i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          Key_ key;
          buffer.enterKey(context);
          deserialize(key, buffer, version, context);
          buffer.leaveKey(context);
-         Value_ val;
+         typename std::map<Key_, Value_, Comp_, Alloc_>::iterator iter
+               = elements.emplace_hint(elements.end(), std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::tuple<>());
          buffer.enterValue(context);
-         deserialize(val, buffer, version, context);
+         deserialize(iter->second, buffer, version, context);
          buffer.leaveValue(context);
-         elements[std::move(key)] = std::move(val);
       }
       buffer.leaveMap(context);
    }
@@ -174,60 +680,47 @@ namespace Private {
    void deserialize(std::multimap<Key_, Value_, Comp_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::multimap<Key_, Value_, Comp_, Alloc_>::size_type size;
       buffer.enterMap(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
       for (typename std::multimap<Key_, Value_, Comp_, Alloc_>::size_type i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          Key_ key;
          buffer.enterKey(context);
          deserialize(key, buffer, version, context);
          buffer.leaveKey(context);
-         Value_ val;
+         typename std::multimap<Key_, Value_, Comp_, Alloc_>::iterator iter
+               = elements.emplace_hint(elements.end(), std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::tuple<>());
          buffer.enterValue(context);
-         deserialize(val, buffer, version, context);
+         deserialize(iter->second, buffer, version, context);
          buffer.leaveValue(context);
-         elements.insert( std::move(std::pair<Key_, Value_>(std::move(key), std::move(val))) );
       }
       buffer.leaveMap(context);
    }
 
    template <class Element_, class Container_>
    void deserialize(std::queue<Element_, Container_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
-      typename std::queue<Element_, Container_>::size_type size;
-      buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      for (typename std::queue<Element_, Container_>::size_type i = 0; i < size; ++i) {
-         Element_ element;
-         buffer.nextCollectionElement(context);
-         deserialize(element, buffer, version, context);
-         elements.push(std::move(element));
-      }
-      buffer.leaveCollection(context);
+      deserialize(AdaptorContainer<std::queue<Element_, Container_> >::get(elements), buffer, version, context);
    }
 
    template <class Element_, class Container_, class Comp_>
    void deserialize(std::priority_queue<Element_, Container_, Comp_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
-      typename std::priority_queue<Element_, Container_, Comp_>::size_type size;
-      buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      for (typename std::priority_queue<Element_, Container_, Comp_>::size_type i = 0; i < size; ++i) {
-         Element_ element;
-         buffer.nextCollectionElement(context);
-         deserialize(element, buffer, version, context);
-         elements.push(std::move(element));
-      }
-      buffer.leaveCollection(context);
+      typedef AdaptorContainer<std::priority_queue<Element_, Container_, Comp_> > Adaptor;
+      Container_& container = Adaptor::get(elements);
+      deserialize(container, buffer, version, context);
+      std::make_heap(container.begin(), container.end(), Adaptor::template comparator<Comp_>(elements));
    }
 
    template <class Key_, class Comp_, class Alloc_>
    void deserialize(std::set<Key_, Comp_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::set<Key_, Comp_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
       for (typename std::set<Key_, Comp_, Alloc_>::size_type i = 0; i < size; ++i) {
          Key_ element;
          buffer.nextCollectionElement(context);
          deserialize(element, buffer, version, context);
-         elements.insert(std::move(element));
+         elements.emplace_hint(elements.end(), std::move(element));
       }
       buffer.leaveCollection(context);
    }
@@ -236,44 +729,80 @@ namespace Private {
    void deserialize(std::multiset<Key_, Comp_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::multiset<Key_, Comp_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
       for (typename std::multiset<Key_, Comp_, Alloc_>::size_type i = 0; i < size; ++i) {
          Key_ element;
          buffer.nextCollectionElement(context);
          deserialize(element, buffer, version, context);
-         elements.insert(std::move(element));
+         elements.emplace_hint(elements.end(), std::move(element));
       }
       buffer.leaveCollection(context);
    }
 
    template <class Element_, class Container_>
    void deserialize(std::stack<Element_, Container_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
-      typename std::stack<Element_, Container_>::size_type size;
-      buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      std::vector<Element_> temp;
-      for (typename std::stack<Element_, Container_>::size_type i = 0; i < size; ++i) {
-         Element_ el;
-         buffer.nextCollectionElement(context);
-         deserialize(el, buffer, version, context);
-         temp.push_back(el);
-      }
-      buffer.leaveCollection(context);
-      for ( typename std::vector<Element_>::const_reverse_iterator iter = temp.rbegin();
-            iter != temp.rend(); ++iter )
-         elements.push(std::move(*iter));
+      Container_& container = AdaptorContainer<std::stack<Element_, Container_> >::get(elements);
+      deserialize(container, buffer, version, context);
+      std::reverse(container.begin(), container.end());
    }
 
    template <class Element_, class Alloc_>
    void deserialize(std::vector<Element_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::vector<Element_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      std::vector<std::size_t> offsets;
+      ReadParts parts;
+      readChunkIndex(size, MinEncodedSize<Element_>::value, buffer, context, offsets, parts);
+      if (!parts.empty()) {
+         elements.resize(size);
+         deserializeChunks(elements.begin(), offsets, parts, buffer, version, context);
+         buffer.leaveCollection(context);
+         return;
+      }
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<Element_>::value));
       for (typename std::vector<Element_, Alloc_>::size_type i = 0; i < size; ++i) {
-         Element_ el;
+         if (i == elements.size())
+            elements.emplace_back();
+         buffer.nextCollectionElement(context);
+         deserialize(elements[i], buffer, version, context);
+      }
+      if (elements.size() > size)
+         elements.erase(elements.begin() + size, elements.end());
+      buffer.leaveCollection(context);
+   }
+
+   template <class Alloc_>
+   void deserialize(std::vector<bool, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+      typename std::vector<bool, Alloc_>::size_type size;
+      buffer.enterCollection(context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
+      std::vector<std::size_t> offsets;
+      ReadParts parts;
+      readChunkIndex(size, MinEncodedSize<bool>::value, buffer, context, offsets, parts);
+      if (!parts.empty()) {
+         elements.reserve(size);
+         for (ReadParts::iterator part = parts.begin(); part != parts.end(); ++part) {
+            for (std::size_t i = offsets[part - parts.begin()]; i < offsets[part - parts.begin() + 1]; ++i) {
+               bool el;
+               (*part)->nextCollectionElement(context);
+               deserialize(el, **part, version, context);
+               elements.push_back(el);
+            }
+            (*part)->leavePart();
+            buffer.addPartAllocations(**part);
+         }
+         buffer.leaveCollection(context);
+         return;
+      }
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<bool>::value));
+      for (typename std::vector<bool, Alloc_>::size_type i = 0; i < size; ++i) {
+         bool el;
          buffer.nextCollectionElement(context);
          deserialize(el, buffer, version, context);
-         elements.push_back(std::move(el));
+         elements.push_back(el);
       }
       buffer.leaveCollection(context);
    }
@@ -282,7 +811,17 @@ namespace Private {
    void deserialize(std::array<Element_, size_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::array<Element_, size_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      std::vector<std::size_t> offsets;
+      ReadParts parts;
+      readChunkIndex(size, MinEncodedSize<Element_>::value, buffer, context, offsets, parts);
+      if (!parts.empty()) {
+         if (size != size_)
+            throw Exception("Input data is corrupt");
+         deserializeChunks(elements.begin(), offsets, parts, buffer, version, context);
+         buffer.leaveCollection(context);
+         return;
+      }
       for (typename std::array<Element_, size_>::size_type i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          deserialize(elements[i], buffer, version, context);
@@ -294,15 +833,17 @@ namespace Private {
    void deserialize(std::forward_list<Element_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       typename std::forward_list<Element_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      typename std::forward_list<Element_, Alloc_>::const_iterator iter = elements.before_begin();
+      readCollectionSize(elements, size, buffer, context);
+      typename std::forward_list<Element_, Alloc_>::iterator previous = elements.before_begin();
       for (typename std::forward_list<Element_, Alloc_>::size_type i = 0; i < size; ++i) {
-         Element_ el;
+         typename std::forward_list<Element_, Alloc_>::iterator iter = std::next(previous);
+         if (iter == elements.end())
+            iter = elements.emplace_after(previous);
          buffer.nextCollectionElement(context);
-         deserialize(el, buffer, version, context);
-         elements.insert_after(iter, std::move(el));
-         ++iter;
+         deserialize(*iter, buffer, version, context);
+         previous = iter;
       }
+      elements.erase_after(previous, elements.end());
       buffer.leaveCollection(context);
    }
 
@@ -311,18 +852,20 @@ namespace Private {
                    , AbstractReadBuffer& buffer, int version, const Context& context ) throw(Exception) {
       typename std::unordered_map<Key_, Value_, Hash_, Pred_, Alloc_>::size_type size;
       buffer.enterMap(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<std::pair<Key_, Value_>>::value));
       for (typename std::unordered_map<Key_, Value_, Hash_, Pred_, Alloc_>::size_type i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          Key_ key;
          buffer.enterKey(context);
          deserialize(key, buffer, version, context);
          buffer.leaveKey(context);
-         Value_ val;
+         typename std::unordered_map<Key_, Value_, Hash_, Pred_, Alloc_>::iterator iter
+               = elements.emplace(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::tuple<>()).first;
          buffer.enterValue(context);
-         deserialize(val, buffer, version, context);
+         deserialize(iter->second, buffer, version, context);
          buffer.leaveValue(context);
-         elements[std::move(key)] = std::move(val);
       }
       buffer.leaveMap(context);
    }
@@ -332,18 +875,20 @@ namespace Private {
                    , AbstractReadBuffer& buffer, int version, const Context& context ) throw(Exception) {
       typename std::unordered_multimap<Key_, Value_, Hash_, Pred_, Alloc_>::size_type size;
       buffer.enterMap(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<std::pair<Key_, Value_>>::value));
       for (typename std::unordered_multimap<Key_, Value_, Hash_, Pred_, Alloc_>::size_type i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          Key_ key;
          buffer.enterKey(context);
          deserialize(key, buffer, version, context);
          buffer.leaveKey(context);
-         Value_ val;
+         typename std::unordered_multimap<Key_, Value_, Hash_, Pred_, Alloc_>::iterator iter
+               = elements.emplace(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::tuple<>());
          buffer.enterValue(context);
-         deserialize(val, buffer, version, context);
+         deserialize(iter->second, buffer, version, context);
          buffer.leaveValue(context);
-         elements.insert( std::move(std::pair<Key_, Value_>(std::move(key), std::move(val))) );
       }
       buffer.leaveMap(context);
    }
@@ -353,12 +898,14 @@ namespace Private {
                    , AbstractReadBuffer& buffer, int version, const Context& context ) throw(Exception) {
       typename std::unordered_set<Key_, Hash_, Pred_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<Key_>::value));
       for (typename std::unordered_set<Key_, Hash_, Pred_, Alloc_>::size_type i = 0; i < size; ++i) {
          Key_ element;
          buffer.nextCollectionElement(context);
          deserialize(element, buffer, version, context);
-         elements.insert(std::move(element));
+         elements.emplace(std::move(element));
       }
       buffer.leaveCollection(context);
    }
@@ -368,12 +915,14 @@ namespace Private {
                    , AbstractReadBuffer& buffer, int version, const Context& context ) throw(Exception) {
       typename std::unordered_multiset<Key_, Hash_, Pred_, Alloc_>::size_type size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
+      readCollectionSize(elements, size, buffer, context);
+      elements.clear();
+      elements.reserve(buffer.reservableSize(size, MinEncodedSize<Key_>::value));
       for (typename std::unordered_multiset<Key_, Hash_, Pred_, Alloc_>::size_type i = 0; i < size; ++i) {
          Key_ element;
          buffer.nextCollectionElement(context);
          deserialize(element, buffer, version, context);
-         elements.insert(std::move(element));
+         elements.emplace(std::move(element));
       }
       buffer.leaveCollection(context);
    }
@@ -384,6 +933,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -424,6 +974,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -448,6 +999,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -467,7 +1019,7 @@ namespace Private {
             std::string dynamicName;
             buffer.readTypeId(dynamicName, staticContext);
             void* p = PolymorphicSerializer::instance().deserialize(dynamicName, buffer, version, idField, staticContext);
-            p = PolymorphicSerializer::instance().getCast(dynamicName, staticName)(p);
+            p = PolymorphicSerializer::instance().cast(dynamicName, staticName, p);
             ptr = std::shared_ptr<Element_>(reinterpret_cast<Element_*>(p));
          } else {
             ptr = std::shared_ptr<Element_>(new Element_());
@@ -488,6 +1040,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -512,6 +1065,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -537,6 +1091,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr.reset();
          return;
       }
 
@@ -562,6 +1117,7 @@ namespace Private {
       IdField idField = staticContext.getClassContext().getRootIdField();
       idField.read(buffer, staticContext);
       if (idField.isNull()) {
+         ptr = 0;
          return;
       }
 
@@ -578,10 +1134,19 @@ namespace Private {
             std::string className;
             buffer.readTypeId(className, context);
             void* p = PolymorphicSerializer::instance().deserialize(className, buffer, version, idField, staticContext);
+            // Polymorphic targets live on the heap, an arena deletes them when it's reset.
+            Arena* arena = Arena::current();
+            if (arena != 0) {
+               PolymorphicFactory::DeleteFunction deleteObject = PolymorphicSerializer::instance().getDelete(className);
+               try {
+                  arena->addDestructor(deleteObject, p);
+               }
+               catch(...) { deleteObject(p); throw; }
+            }
             p = PolymorphicSerializer::instance().cast(className, staticName, p);
             ptr = reinterpret_cast<Element_*>(p);
          } else {
-            ptr = new Element_();
+            ptr = createObject<Element_>();
             idField.assign(reinterpret_cast<void*>(ptr), staticName);
             deserialize(*ptr, buffer, version, staticContext);
          }
@@ -615,8 +1180,9 @@ namespace Private {
    void deserialize(std::valarray<Number_>& obj, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       size_t size;
       buffer.enterCollection(context);
-      buffer.readCollectionSize(size, context);
-      obj = std::valarray<Number_>(size);
+      readCollectionSize(obj, size, buffer, context);
+      if (obj.size() != size)
+         obj.resize(size);
       for (size_t i = 0; i < size; ++i) {
          buffer.nextCollectionElement(context);
          deserialize(obj[i], buffer, version, context);
@@ -624,6 +1190,11 @@ namespace Private {
       buffer.leaveCollection(context);
    }
 
+   template <class Value_>
+   void deserialize(Cached<Value_>& cached, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+      deserialize(cached.mutate(), buffer, version, context);
+   }
+
    template <>
    void deserialize(bool& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       buffer.read(value, context);
@@ -692,13 +1263,21 @@ namespace Private {
    template <>
    void deserialize(std::string& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       buffer.read(value, context);
+      buffer.checkStringLength(value.length());
    }
 
    template <>
-   void deserialize(std::wstring& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+   void deserialize(ArenaString& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
       std::string tmp;
       buffer.read(tmp, context);
-      value = boost::locale::conv::utf_to_utf<wchar_t>(tmp);
+      buffer.checkStringLength(tmp.length());
+      value.assign(tmp.data(), tmp.length());
+   }
+
+   template <>
+   void deserialize(std::wstring& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception) {
+      buffer.read(value, context);
+      buffer.checkStringLength(value.length());
    }
 
 } // namespace Private
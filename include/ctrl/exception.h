@@ -27,6 +27,7 @@
 #ifndef CTRLEXCEPTION_H_
 #define CTRLEXCEPTION_H_
 
+#include <cstddef>
 #include <string>
 #include <exception>
 
@@ -34,11 +35,19 @@ namespace ctrl {
 
 class Exception : public std::exception {
 public:
-   Exception(const std::string& reason) : m_reason(reason) {
+   static const std::size_t unknownPosition = static_cast<std::size_t>(-1);
+
+   Exception(const std::string& reason) : m_reason(reason), m_position(unknownPosition) {
 
    }
 
-   Exception(const Exception& that) : m_reason(that.m_reason) {
+   // Errors found in the input can carry the offset in the input at which they
+   // were detected.
+   Exception(const std::string& reason, std::size_t position) : m_reason(reason), m_position(position) {
+
+   }
+
+   Exception(const Exception& that) : m_reason(that.m_reason), m_position(that.m_position) {
 
    }
 
@@ -46,8 +55,11 @@ public:
 
    virtual const char* what() const throw () { return m_reason.c_str(); }
 
+   std::size_t position() const { return m_position; }
+
 private:
    std::string m_reason;
+   std::size_t m_position;
 };
 
 } // namespace ctrl
@@ -53,6 +53,9 @@ class AbstractReadBuffer;
 
 class Context;
 
+template <class Value_>
+class Cached;
+
 namespace Private {
 
    template <class ConcreteClass_>
@@ -91,6 +94,9 @@ namespace Private {
    template <class Element_, class Alloc_>
    void deserialize(std::vector<Element_, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
 
+   template <class Alloc_>
+   void deserialize(std::vector<bool, Alloc_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
+
    template <class Element_, size_t size_>
    void deserialize(std::array<Element_, size_>& elements, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
 
@@ -143,6 +149,9 @@ namespace Private {
    template <class Number_>
    void deserialize(std::valarray<Number_>& obj, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
 
+   template <class Value_>
+   void deserialize(Cached<Value_>& cached, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
+
    template <>
    void deserialize(bool& value, AbstractReadBuffer& buffer, int version, const Context& context) throw(Exception);
 
@@ -52,6 +52,9 @@ class AbstractWriteBuffer;
 
 class Context;
 
+template <class Value_>
+class Cached;
+
 namespace Private {
 
    template <class ConcreteClass_>
@@ -142,6 +145,9 @@ namespace Private {
    template <class Number_>
    void serialize(const std::valarray<Number_>& obj, AbstractWriteBuffer& buffer, int version, const Context& context);
 
+   template <class Value_>
+   void serialize(const Cached<Value_>& cached, AbstractWriteBuffer& buffer, int version, const Context& context);
+
    template <>
    void serialize(const bool& value, AbstractWriteBuffer& buffer, int version, const Context& context);
 
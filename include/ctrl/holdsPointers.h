@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HOLDSPOINTERS_H_
+#define HOLDSPOINTERS_H_
+
+#include <utility>
+#include <complex>
+#include <ctrl/typemanip.h>
+#include <ctrl/cached.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Whether a value of a type can reach a pointer through its elements, bases
+   // or members. Chunks written on their own thread don't share pointer ids, so
+   // members marked with CTRL_PARALLEL or CTRL_WITH_CHUNK_INDEX can't hold any.
+   template <class T_>
+   struct HoldsPointers;
+
+   template <class ConcreteClass_, class Indices_>
+   struct HoldsPointersMembers {
+      typedef typename ConcreteClass_::template CTRL_MemberType<Indices_::Head::value>::Type Type;
+      enum { value = HoldsPointers<Type>::value
+                     || HoldsPointersMembers<ConcreteClass_, typename Indices_::Tail>::value };
+   };
+
+   template <class ConcreteClass_>
+   struct HoldsPointersMembers<ConcreteClass_, NullType> {
+      enum { value = false };
+   };
+
+   template <class TList_>
+   struct HoldsPointersBases {
+      typedef typename TList_::Head Base;
+      enum { value = HoldsPointersBases<typename Base::CTRL_BaseClasses>::value
+                     || HoldsPointersMembers<Base, typename Base::CTRL_MemberIndices>::value
+                     || HoldsPointersBases<typename TList_::Tail>::value };
+   };
+
+   template <>
+   struct HoldsPointersBases<NullType> {
+      enum { value = false };
+   };
+
+   template <class T_, bool isClass_ = !IsFundamental<T_>::value && !IsPointer<T_>::value
+                                    && !IsCollection<T_>::value && !IsMap<T_>::value>
+   struct HoldsPointersImpl {
+      enum { value = HoldsPointersBases<typename T_::CTRL_BaseClasses>::value
+                     || HoldsPointersMembers<T_, typename T_::CTRL_MemberIndices>::value };
+   };
+
+   template <class T_, bool isCollection_ = IsCollection<T_>::value, bool isMap_ = IsMap<T_>::value>
+   struct HoldsPointersContainer {
+      enum { value = IsPointer<T_>::value };
+   };
+
+   template <class T_>
+   struct HoldsPointersContainer<T_, true, false> {
+      enum { value = HoldsPointers<typename T_::value_type>::value };
+   };
+
+   template <class T_>
+   struct HoldsPointersContainer<T_, false, true> {
+      enum { value = HoldsPointers<typename T_::key_type>::value
+                     || HoldsPointers<typename T_::mapped_type>::value };
+   };
+
+   template <class T_>
+   struct HoldsPointersImpl<T_, false> {
+      enum { value = HoldsPointersContainer<T_>::value };
+   };
+
+   template <class T_>
+   struct HoldsPointers {
+      enum { value = HoldsPointersImpl<T_>::value };
+   };
+
+   template <class T_>
+   struct HoldsPointers<const T_> {
+      enum { value = HoldsPointers<T_>::value };
+   };
+
+   template <class First_, class Second_>
+   struct HoldsPointers<std::pair<First_, Second_>> {
+      enum { value = HoldsPointers<First_>::value || HoldsPointers<Second_>::value };
+   };
+
+   template <class Number_>
+   struct HoldsPointers<std::complex<Number_>> {
+      enum { value = false };
+   };
+
+   template <class Value_>
+   struct HoldsPointers<Cached<Value_>> {
+      enum { value = HoldsPointers<Value_>::value };
+   };
+
+   // Called for every member, only checks the ones split into chunks.
+   template <class Type_, bool chunked_>
+   struct CheckChunkedMember {
+      static_assert(!HoldsPointers<Type_>::value,
+                    "CTRL_PARALLEL and CTRL_WITH_CHUNK_INDEX can't be used on members holding pointers");
+      static void check() {}
+   };
+
+   template <class Type_>
+   struct CheckChunkedMember<Type_, false> {
+      static void check() {}
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // HOLDSPOINTERS_H_
@@ -0,0 +1,162 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+// Instrumentation is only compiled in when CTRL_INSTRUMENTATION is defined, for
+// the library as well as for the code using it. Otherwise the hooks below expand
+// to nothing.
+
+#ifdef CTRL_INSTRUMENTATION
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace ctrl {
+
+   class AbstractWriteBuffer;
+
+   class AbstractReadBuffer;
+
+   // Collects counters for every top-level serialization or deserialization call
+   // made on a thread, both for the call as a whole and per reflected type. When
+   // a call returns its counters are added to the totals and passed to the
+   // callback, if one is set. Bytes, allocations and time of a type include its
+   // nested objects, members and resolved pointers only count those of the type
+   // itself. Objects written or read on the helper threads of CTRL_PARALLEL
+   // members are not counted. XML input is parsed as a whole before reading
+   // starts, so calls reading XML report no bytes.
+   class Instrumentation {
+   public:
+      enum Direction { Write, Read };
+
+      struct Counters {
+         Counters();
+
+         void add(const Counters& that);
+
+         unsigned long long calls;
+         unsigned long long objects;
+         unsigned long long members;
+         unsigned long long resolvedPointers;
+         unsigned long long repositorySize;
+         unsigned long long bytes;
+         unsigned long long allocations;
+         unsigned long long nanoseconds;
+      };
+
+      struct Call {
+         Direction direction;
+         std::string typeName;
+         Counters total;
+         std::map<std::string, Counters> types;
+      };
+
+      struct Totals {
+         std::map<std::string, Counters> calls;
+         std::map<std::string, Counters> types;
+      };
+
+      typedef std::function<void(const Call&)> Callback;
+
+      // The library can't see allocations made by the standard containers, so
+      // allocations are only counted when the application provides a function
+      // returning the number of allocations made so far, e.g. from a replaced
+      // operator new.
+      typedef unsigned long long (*AllocationCounter)();
+
+      static void setCallback(const Callback& callback);
+      static void setAllocationCounter(AllocationCounter counter);
+
+      static Totals totals(Direction direction);
+      static void reset();
+   };
+
+namespace Private {
+
+   struct InstrumentationFrame;
+
+   class InstrumentedCall {
+   public:
+      InstrumentedCall(const std::string& typeName, AbstractWriteBuffer& buffer);
+      InstrumentedCall(const std::string& typeName, AbstractReadBuffer& buffer);
+      ~InstrumentedCall();
+
+   private:
+      InstrumentedCall(const InstrumentedCall&);
+      InstrumentedCall& operator=(const InstrumentedCall&);
+
+      InstrumentationFrame* m_frame;
+      InstrumentationFrame* m_previous;
+   };
+
+   class InstrumentedObject {
+   public:
+      InstrumentedObject(const std::string& typeName);
+      ~InstrumentedObject();
+
+   private:
+      InstrumentedObject(const InstrumentedObject&);
+      InstrumentedObject& operator=(const InstrumentedObject&);
+
+      InstrumentationFrame* m_frame;
+      Instrumentation::Counters* m_counters;
+      Instrumentation::Counters* m_outer;
+      std::size_t m_position;
+      unsigned long long m_allocations;
+      std::chrono::steady_clock::time_point m_start;
+   };
+
+   void instrumentMember();
+   void instrumentResolvedPointer();
+
+} // namespace Private
+
+} // namespace ctrl
+
+#define CTRL_INSTRUMENT_CALL(ClassName_, buffer_)                                                                      \
+   ctrl::Private::InstrumentedCall CTRL_instrumentedCall(ClassName_::CTRL_staticName(), buffer_)
+
+#define CTRL_INSTRUMENT_OBJECT(ClassName_)                                                                             \
+   ctrl::Private::InstrumentedObject CTRL_instrumentedObject(ClassName_::CTRL_staticName())
+
+#define CTRL_INSTRUMENT_MEMBER() ctrl::Private::instrumentMember()
+
+#define CTRL_INSTRUMENT_RESOLVED_POINTER() ctrl::Private::instrumentResolvedPointer()
+
+#else
+
+#define CTRL_INSTRUMENT_CALL(ClassName_, buffer_)
+#define CTRL_INSTRUMENT_OBJECT(ClassName_)
+#define CTRL_INSTRUMENT_MEMBER()
+#define CTRL_INSTRUMENT_RESOLVED_POINTER()
+
+#endif // CTRL_INSTRUMENTATION
+
+#endif // INSTRUMENTATION_H_
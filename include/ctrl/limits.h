@@ -0,0 +1,57 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIMITS_H_
+#define LIMITS_H_
+
+#include <cstddef>
+#include <limits>
+
+namespace ctrl {
+
+   // Bounds on what a single deserialization may read, for input that can't be
+   // trusted. Allocation adds up the size in bytes of the elements of every
+   // collection and the characters of every string read, so it is a lower
+   // bound on the memory the result takes. Exceeding a limit throws a ctrl::Exception. Every limit is
+   // unbounded by default.
+   struct Limits {
+      Limits()
+         : maxDepth(std::numeric_limits<std::size_t>::max())
+         , maxCollectionSize(std::numeric_limits<std::size_t>::max())
+         , maxStringLength(std::numeric_limits<std::size_t>::max())
+         , maxAllocation(std::numeric_limits<std::size_t>::max()) {
+
+      }
+
+      std::size_t maxDepth;
+      std::size_t maxCollectionSize;
+      std::size_t maxStringLength;
+      std::size_t maxAllocation;
+   };
+
+} // namespace ctrl
+
+#endif // LIMITS_H_
@@ -40,6 +40,7 @@ namespace Private {
       virtual void* getProperty(const std::type_info& type) const = 0;
       virtual std::string getName() const = 0;
       virtual bool isFundamental() const = 0;
+      virtual bool isFloatingPoint() const = 0;
       virtual bool isCollection() const = 0;
       virtual bool isMap() const = 0;
       virtual bool isMapKeyFundamental() const = 0;
@@ -61,6 +62,10 @@ namespace Private {
          return IsFundamental<typename ConcreteClass_::template CTRL_MemberType<index_>::Type>::value;
       }
 
+      virtual bool isFloatingPoint() const {
+         return IsFloatingPoint<typename ConcreteClass_::template CTRL_MemberType<index_>::Type>::value;
+      }
+
       virtual bool isCollection() const {
          return IsCollection<typename ConcreteClass_::template CTRL_MemberType<index_>::Type>::value;
       }
@@ -110,6 +115,11 @@ namespace Private {
       virtual bool isFundamental() const {
          return true;
       }
+
+      virtual bool isFloatingPoint() const {
+         return false;
+      }
+
       virtual bool isCollection() const {
          return false;
       }
@@ -165,6 +175,10 @@ public:
       return m_pimpl->isFundamental();
    }
 
+   bool isFloatingPoint() const {
+      return m_pimpl->isFloatingPoint();
+   }
+
    bool isCollection() const {
 	   return m_pimpl->isCollection();
    }
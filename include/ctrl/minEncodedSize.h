@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MINENCODEDSIZE_H_
+#define MINENCODEDSIZE_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <ctrl/typemanip.h>
+#include <ctrl/properties.h>
+#include <ctrl/cached.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   // The least number of bytes the binary format spends on a value of a type,
+   // whatever its content. A collection whose elements need more than the bytes
+   // left in the input can't be valid, however large its size claims to be.
+   template <class T_>
+   struct MinEncodedSize;
+
+   template <class ConcreteClass_, class Indices_>
+   struct MinEncodedMembersSize {
+      enum { index = Indices_::Head::value };
+      typedef typename ConcreteClass_::template CTRL_MemberType<index>::Type Type;
+
+      // Id fields aren't written and newer members are skipped by older readers.
+      enum { written = ConcreteClass_::template CTRL_MemberVersion<index>::value <= 1
+                       && !ConcreteClass_::template CTRL_HasProperty<AsIdField, index>::value };
+
+      static const std::size_t value = (written ? MinEncodedSize<Type>::value : 0)
+                                     + MinEncodedMembersSize<ConcreteClass_, typename Indices_::Tail>::value;
+   };
+
+   template <class ConcreteClass_>
+   struct MinEncodedMembersSize<ConcreteClass_, NullType> {
+      static const std::size_t value = 0;
+   };
+
+   template <class TList_>
+   struct MinEncodedBasesSize {
+      typedef typename TList_::Head Base;
+      static const std::size_t value = MinEncodedBasesSize<typename Base::CTRL_BaseClasses>::value
+                                     + MinEncodedMembersSize<Base, typename Base::CTRL_MemberIndices>::value
+                                     + MinEncodedBasesSize<typename TList_::Tail>::value;
+   };
+
+   template <>
+   struct MinEncodedBasesSize<NullType> {
+      static const std::size_t value = 0;
+   };
+
+   template <class T_, bool isClass_ = !IsFundamental<T_>::value && !IsPointer<T_>::value
+                                    && !IsCollection<T_>::value && !IsMap<T_>::value>
+   struct MinEncodedSizeImpl {
+      static const std::size_t value = MinEncodedBasesSize<typename T_::CTRL_BaseClasses>::value
+                                     + MinEncodedMembersSize<T_, typename T_::CTRL_MemberIndices>::value;
+   };
+
+   // Numbers are written with their own size, strings and collections start
+   // with their size and pointers with a null flag.
+   template <class T_>
+   struct MinEncodedSizeImpl<T_, false> {
+      static const std::size_t value = IsPointer<T_>::value ? 1
+                                     : std::is_arithmetic<T_>::value ? sizeof(T_) : sizeof(std::size_t);
+   };
+
+   template <class T_>
+   struct MinEncodedSize {
+      static const std::size_t value = MinEncodedSizeImpl<T_>::value;
+   };
+
+   template <size_t size_>
+   struct MinEncodedSize<std::bitset<size_>> {
+      static const std::size_t value = (size_ + 7) / 8;
+   };
+
+   template <class Element_, size_t size_>
+   struct MinEncodedSize<std::array<Element_, size_>> {
+      static const std::size_t value = sizeof(std::size_t) + size_ * MinEncodedSize<Element_>::value;
+   };
+
+   template <class First_, class Second_>
+   struct MinEncodedSize<std::pair<First_, Second_>> {
+      static const std::size_t value = MinEncodedSize<typename std::remove_const<First_>::type>::value
+                                     + MinEncodedSize<Second_>::value;
+   };
+
+   template <class Number_>
+   struct MinEncodedSize<std::complex<Number_>> {
+      static const std::size_t value = 2 * sizeof(double);
+   };
+
+   template <class Value_>
+   struct MinEncodedSize<Cached<Value_>> {
+      static const std::size_t value = MinEncodedSize<Value_>::value;
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // MINENCODEDSIZE_H_
@@ -0,0 +1,135 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PARALLELCHUNKS_H_
+#define PARALLELCHUNKS_H_
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <ctrl/context.h>
+#include <ctrl/properties.h>
+
+namespace ctrl {
+
+namespace Private {
+
+   // Splits large collections of members marked with CTRL_PARALLEL into chunks
+   // that are processed on separate threads. The property gives the maximum
+   // number of threads, or 0 for one per hardware thread. Members marked with
+   // CTRL_WITH_CHUNK_INDEX are always split, and the offset and size of every
+   // chunk is written in front of the elements so they can be read in parallel
+   // as well.
+   class ParallelChunks {
+   public:
+      enum { minChunkSize = 4096, maxIndexedChunks = 256 };
+
+      static std::size_t threads(const Context& context) {
+         std::size_t threads = context.getOwningMember().getProperty<Parallel>();
+         if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+         }
+         return threads;
+      }
+
+      static std::size_t count(std::size_t size, const Context& context) {
+         if (size < 2 * minChunkSize) {
+            return 1;
+         }
+         return std::min<std::size_t>(threads(context), size / minChunkSize);
+      }
+
+      static bool indexed(std::size_t size, const Context& context) {
+         return size >= 2 * minChunkSize && context.getOwningMember().getProperty<WithChunkIndex>();
+      }
+
+      static std::size_t indexedCount(std::size_t size) {
+         return std::min<std::size_t>(maxIndexedChunks, size / minChunkSize);
+      }
+
+      static std::size_t begin(std::size_t size, std::size_t nbChunks, std::size_t chunk) {
+         return size / nbChunks * chunk + std::min(chunk, size % nbChunks);
+      }
+
+      // Calls function(chunk) for every chunk, spread over at most nbThreads
+      // threads, of which the calling thread is one. Chunks of threads that
+      // couldn't be started run on the calling thread. The first exception thrown
+      // by any chunk is rethrown once all threads have finished.
+      template <class Function_>
+      static void run(std::size_t nbChunks, std::size_t nbThreads, Function_ function) {
+         nbThreads = std::max<std::size_t>(1, std::min(nbThreads, nbChunks));
+         std::vector<std::exception_ptr> errors(nbThreads);
+         std::vector<std::thread> threads;
+         try {
+            threads.reserve(nbThreads - 1);
+            for (std::size_t i = 0; i + 1 < nbThreads; ++i) {
+               threads.push_back(std::thread(Runner<Function_>(function,
+                     begin(nbChunks, nbThreads, i), begin(nbChunks, nbThreads, i + 1), errors[i])));
+            }
+         }
+         catch (...) {
+         }
+         Runner<Function_>(function, begin(nbChunks, nbThreads, threads.size()), nbChunks, errors.back())();
+         for (std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); ++iter) {
+            iter->join();
+         }
+         for (std::vector<std::exception_ptr>::iterator iter = errors.begin(); iter != errors.end(); ++iter) {
+            if (*iter) {
+               std::rethrow_exception(*iter);
+            }
+         }
+      }
+
+   private:
+      template <class Function_>
+      struct Runner {
+         Runner(Function_& function_, std::size_t first_, std::size_t last_, std::exception_ptr& error_)
+               : function(function_), first(first_), last(last_), error(error_) {}
+
+         void operator()() {
+            try {
+               for (std::size_t chunk = first; chunk != last; ++chunk) {
+                  function(chunk);
+               }
+            }
+            catch (...) {
+               error = std::current_exception();
+            }
+         }
+
+         Function_& function;
+         std::size_t first;
+         std::size_t last;
+         std::exception_ptr& error;
+      };
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+#endif // PARALLELCHUNKS_H_
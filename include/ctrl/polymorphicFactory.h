@@ -41,12 +41,15 @@ namespace Private {
 
    class PolymorphicFactory {
    public:
+      typedef void (*DeleteFunction)(void*);
+
       class Impl {
       public:
          Impl();
          virtual ~Impl();
          virtual void* deserialize(AbstractReadBuffer& buffer, const IdField& idField, const std::string& className,
                                    int version, const Context& context) const = 0;
+         virtual DeleteFunction getDelete() const = 0;
       };
 
       PolymorphicFactory();
@@ -57,6 +60,7 @@ namespace Private {
 
       void* deserialize(AbstractReadBuffer& buffer, const IdField& idField, const std::string& className,
                         int version, const Context& context) const;
+      DeleteFunction getDelete() const;
 
    private:
       boost::shared_ptr<Impl> m_pimpl;
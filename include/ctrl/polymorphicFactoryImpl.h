@@ -49,6 +49,15 @@ namespace Private {
          }
          catch(...) { delete ptr; throw; }
       }
+
+      virtual PolymorphicFactory::DeleteFunction getDelete() const {
+         return &deleteObject;
+      }
+
+   private:
+      static void deleteObject(void* ptr) {
+         delete reinterpret_cast<ConcreteClass_*>(ptr);
+      }
    };
 
 } // namespace Private
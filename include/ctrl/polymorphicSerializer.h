@@ -29,8 +29,11 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include <ctrl/polymorphicFactory.h>
 
 namespace ctrl {
@@ -43,8 +46,32 @@ class IdField;
 
 namespace Private {
 
+   // Registrations are collected under a mutex and published as an immutable
+   // snapshot once a lookup doesn't find what it needs in the current one.
+   // Readers only load the current snapshot, so serializing on many threads
+   // needs no lock, and types that are registered later, for instance by a
+   // library that is loaded at runtime, become visible to lookups that start
+   // after the registration. Lookups that succeed don't publish, so a run of
+   // registrations costs one copy of the registry, not one per registration.
+   // Snapshots are kept until the registry is destroyed, so a lookup never sees
+   // one being freed.
+   //
+   // After freeze no more types can be registered. Registrations run from
+   // static initializers, so a late one doesn't throw: it returns -1 and the
+   // name is kept in rejectedTypes.
    class PolymorphicSerializer {
+   public:
+      typedef void* (*CastFunction)(void*);
+
    private:
+      struct Snapshot {
+         std::map<std::string, PolymorphicFactory> factories;
+         std::set<std::string> abstractBaseClasses;
+
+         typedef std::map< std::string, std::map<std::string, CastFunction> > CastMap;
+         CastMap casts;
+      };
+
       PolymorphicSerializer();
 
    public:
@@ -58,23 +85,58 @@ namespace Private {
       int registerAbstract(const std::string& className);
       void* deserialize(const std::string& className, AbstractReadBuffer& buffer, int version,
                         const IdField& idField, const Context& context) const;
+      // Deletes an object returned by deserialize, before it was cast.
+      PolymorphicFactory::DeleteFunction getDelete(const std::string& className) const;
 
-      typedef void* (*CastFunction)(void*);
       int registerCast(const std::string& from, const std::string& to, CastFunction func);
       CastFunction getCast(const std::string& from, const std::string& to) const;
       bool hasCast(const std::string& from, const std::string& to) const;
       void* cast(const std::string& from, const std::string& to, void* p) const;
 
-   private:
-      std::map<std::string, PolymorphicFactory> m_factories;
-      std::vector<std::string> m_abstractBaseClasses;
+      void freeze();
+      bool isFrozen() const;
+      std::vector<std::string> rejectedTypes() const;
 
-      typedef std::map< std::string, std::map<std::string, CastFunction> > CastMap;
-      CastMap m_casts;
+   private:
+      // Calls find on the current snapshot and, when it returns false while
+      // registrations are pending, once more on a newly published one.
+      template <class Find_>
+      bool find(Find_ find) const {
+         if (find(*m_current.load(std::memory_order_acquire)))
+            return true;
+         if (!m_changed.load(std::memory_order_acquire))
+            return false;
+         publish();
+         return find(*m_current.load(std::memory_order_acquire));
+      }
+
+      void publish() const;
+      Snapshot* pending(const std::string& className);
+      CastFunction findCast(const std::string& from, const std::string& to) const;
+
+      mutable std::mutex m_mutex;
+      Snapshot m_pending;
+      std::vector<std::string> m_rejected;
+      mutable std::vector<std::unique_ptr<const Snapshot>> m_snapshots;
+      mutable std::atomic<const Snapshot*> m_current;
+      mutable std::atomic<bool> m_changed;
+      bool m_frozen;
    };
 
 } // namespace Private
 
+// Publishes all polymorphic types registered so far and rejects further
+// registrations. Call it once all libraries are loaded.
+inline void freezePolymorphicTypes() {
+   Private::PolymorphicSerializer::instance().freeze();
+}
+
+// Names of the types whose registration came after freezePolymorphicTypes,
+// for instance because their library was loaded too late.
+inline std::vector<std::string> rejectedPolymorphicTypes() {
+   return Private::PolymorphicSerializer::instance().rejectedTypes();
+}
+
 } // namespace ctrl
 
 #endif // _POLYMORPHICSERIALIZER_H_
@@ -65,7 +65,14 @@ CTRL_DEFINE_PROPERTY(WithName, std::string, "")
 #define CTRL_WITH_NAME(name_) CTRL_PROPERTY(ctrl::WithName, name_)
 
 CTRL_DEFINE_PROPERTY(WithVersion, int, 1)
-#define CTRL_WITH_VERSION(version_) CTRL_PROPERTY(ctrl::WithVersion, version_)
+// The version is also kept as a compile time constant, so that checking it for
+// every member written or read costs no more than a comparison.
+#define CTRL_WITH_VERSION(version_)                                                                                    \
+   CTRL_PROPERTY(ctrl::WithVersion, version_)                                                                          \
+   template <class Dummy_>                                                                                             \
+   struct CTRL_MemberVersion<ctrl::Private::GetMemberIndex<CTRL_ConcreteClass, CTRL_startLine, __LINE__>::index, Dummy_> { \
+      enum { value = version_ };                                                                                       \
+   };
 
 CTRL_DEFINE_PROPERTY(TypeIdFieldName, std::string, "__typeId")
 #define CTRL_TYPE_ID_FIELD_NAME(name_) CTRL_PROPERTY(ctrl::TypeIdFieldName, name_)
@@ -82,6 +89,12 @@ CTRL_DEFINE_PROPERTY(IdFieldAsAttribute, bool, false)
 CTRL_DEFINE_PROPERTY(AsIdField, bool, false)
 #define CTRL_AS_ID_FIELD() CTRL_PROPERTY(ctrl::AsIdField, true)
 
+CTRL_DEFINE_PROPERTY(Parallel, unsigned int, 1)
+#define CTRL_PARALLEL(threads_) CTRL_PROPERTY(ctrl::Parallel, threads_)
+
+CTRL_DEFINE_PROPERTY(WithChunkIndex, bool, false)
+#define CTRL_WITH_CHUNK_INDEX() CTRL_PROPERTY(ctrl::WithChunkIndex, true)
+
 } // namespace ctrl
 
 
@@ -53,11 +53,11 @@ public:
    static void initialize(Dummy_&, int) { }                                                                          \
                                                                                                                        \
    virtual ctrl::ClassContext CTRL_dynamicContext() {                                                                     \
-      return ctrl::ClassContext(new ctrl::Private::ClassContextImpl<ConcreteClass_>());                                \
+      return ctrl::ClassContext(ctrl::Private::ClassContextImpl<ConcreteClass_>::instance());                          \
    }                                                                                                                   \
                                                                                                                        \
    static ctrl::ClassContext CTRL_staticContext() {                                                                       \
-      return ctrl::ClassContext(new ctrl::Private::ClassContextImpl<ConcreteClass_>());                                \
+      return ctrl::ClassContext(ctrl::Private::ClassContextImpl<ConcreteClass_>::instance());                          \
    }                                                                                                                   \
                                                                                                                        \
    virtual std::string CTRL_dynamicName() {                                                                               \
@@ -86,6 +86,11 @@ public:
       typedef ctrl::Private::NullType Type;                                                                            \
    };                                                                                                                  \
                                                                                                                        \
+   template <int index_, class Dummy_ = ctrl::Private::NullType>                                                       \
+   struct CTRL_MemberVersion {                                                                                            \
+      enum { value = 1 };                                                                                              \
+   };                                                                                                                  \
+                                                                                                                       \
    template <int lineNb_, class Dummy_ = ctrl::Private::NullType>                                                      \
    struct CTRL_IsBaseClassPresent {                                                                                       \
       enum { value = false };                                                                                          \
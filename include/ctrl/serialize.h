@@ -28,21 +28,28 @@
 #define SERIALIZE_H_
 
 #include <climits>
-#include <boost/locale.hpp>
+#include <iterator>
 #include <ctrl/forwardSerialize.h>
 #include <ctrl/classSerializer.h>
 #include <ctrl/baseClassSerializer.h>
 #include <ctrl/polymorphicSerializer.h>
 #include <ctrl/platformFormat.h>
+#include <ctrl/adaptorContainer.h>
+#include <ctrl/arena.h>
+#include <ctrl/cached.h>
+#include <ctrl/parallelChunks.h>
+#include <ctrl/instrumentation.h>
 #include <ctrl/buffer/binaryWriteBufferImpl.h>
 #include <ctrl/buffer/xmlWriteBuffer.h>
 #include <ctrl/buffer/jsonWriteBuffer.h>
+#include <ctrl/buffer/bitPacking.h>
 
 namespace ctrl {
 
 template <class ConcreteClass_>
 void toWriteBuffer(const ConcreteClass_& object, AbstractWriteBuffer& buffer, int version) {
-   Context context(ClassContext(new Private::ClassContextImpl<ConcreteClass_>()));
+   CTRL_INSTRUMENT_CALL(ConcreteClass_, buffer);
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass_>::instance()));
    buffer.appendVersion(version, context);
    Private::serialize(object, buffer, version, context);
 }
@@ -65,6 +72,40 @@ char* toBinary(const ConcreteClass_& object, long& length, int version = 1) {
    return toBinary<CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER, ConcreteClass_>(object, length, version);
 }
 
+// Writes the version once, followed by the number of records and each record
+// prefixed with its length. Records don't share pointer ids, so every record can
+// be decoded on its own.
+template <int alignment_, int endian_, class InputIterator_>
+char* toBinaryBatch(InputIterator_ first, InputIterator_ last, long& length, int version = 1) {
+   typedef typename std::iterator_traits<InputIterator_>::value_type ConcreteClass;
+   Private::BinaryWriteBuffer buffer(new Private::BinaryWriteBufferImpl<alignment_, endian_>());
+   CTRL_INSTRUMENT_CALL(ConcreteClass, buffer);
+   Context context(ClassContext(Private::ClassContextImpl<ConcreteClass>::instance()));
+   buffer.appendVersion(version, context);
+   long countOffset = buffer.appendSizePlaceholder();
+   std::size_t count = 0;
+   for (; first != last; ++first, ++count) {
+      long sizeOffset = buffer.appendSizePlaceholder();
+      long begin = buffer.length();
+      buffer.getPointerRepository().clear();
+      Private::serialize(*first, buffer, version, context);
+      buffer.patchSize(sizeOffset, buffer.length() - begin);
+   }
+   buffer.patchSize(countOffset, count);
+   length = buffer.length();
+   return buffer.getData();
+}
+
+template <int alignment_, class InputIterator_>
+char* toBinaryBatch(InputIterator_ first, InputIterator_ last, long& length, int version = 1) {
+   return toBinaryBatch<alignment_, CTRL_BYTE_ORDER, InputIterator_>(first, last, length, version);
+}
+
+template <class InputIterator_>
+char* toBinaryBatch(InputIterator_ first, InputIterator_ last, long& length, int version = 1) {
+   return toBinaryBatch<CTRL_MEMORY_ALIGNMENT, CTRL_BYTE_ORDER, InputIterator_>(first, last, length, version);
+}
+
 template <class ConcreteClass_>
 std::string toXml(const ConcreteClass_& object, bool prettyPrint = false, int version = 1) {
    Private::XmlWriteBuffer buffer(prettyPrint);
@@ -79,10 +120,100 @@ std::string toJson(const ConcreteClass_& object, int indentation = 0) {
    return buffer.getOutput();
 }
 
+// Writers keep their buffer between calls, so encoding a stream of messages
+// only allocates until the buffer has grown to the size of the largest one.
+// The returned output stays valid until the next write. A writer must not be
+// shared between threads; keep one per thread instead.
+template <int alignment_ = CTRL_MEMORY_ALIGNMENT, int endian_ = CTRL_BYTE_ORDER>
+class BinaryWriter {
+public:
+   BinaryWriter() : m_buffer(new Private::BinaryWriteBufferImpl<alignment_, endian_>()) {}
+
+   template <class ConcreteClass_>
+   const char* write(const ConcreteClass_& object, long& length, int version = 1) {
+      m_buffer.reset();
+      toWriteBuffer(object, m_buffer, version);
+      length = m_buffer.length();
+      return m_buffer.data();
+   }
+
+private:
+   BinaryWriter(const BinaryWriter&);
+   BinaryWriter& operator=(const BinaryWriter&);
+
+   Private::BinaryWriteBuffer m_buffer;
+};
+
+// Writes a stream of binary messages that share pointer ids. An object behind a
+// pointer is written in full the first time, later messages only refer to it by
+// id, so it must stay alive and unchanged until reset is called. The messages
+// must be read in order by a single BinaryReadSession.
+template <int alignment_ = CTRL_MEMORY_ALIGNMENT, int endian_ = CTRL_BYTE_ORDER>
+class BinaryWriteSession {
+public:
+   BinaryWriteSession() : m_buffer(new Private::BinaryWriteBufferImpl<alignment_, endian_>()) {}
+
+   template <class ConcreteClass_>
+   const char* write(const ConcreteClass_& object, long& length, int version = 1) {
+      m_buffer.truncate(0);
+      toWriteBuffer(object, m_buffer, version);
+      length = m_buffer.length();
+      return m_buffer.data();
+   }
+
+   // Forgets the objects written so far, the next message writes them again.
+   void reset() {
+      m_buffer.reset();
+   }
+
+private:
+   BinaryWriteSession(const BinaryWriteSession&);
+   BinaryWriteSession& operator=(const BinaryWriteSession&);
+
+   Private::BinaryWriteBuffer m_buffer;
+};
+
+class XmlWriter {
+public:
+   explicit XmlWriter(bool prettyPrint = false) : m_buffer(prettyPrint) {}
+
+   template <class ConcreteClass_>
+   const std::string& write(const ConcreteClass_& object, int version = 1) {
+      m_buffer.reset();
+      toWriteBuffer(object, m_buffer, version);
+      return m_buffer.getOutput();
+   }
+
+private:
+   XmlWriter(const XmlWriter&);
+   XmlWriter& operator=(const XmlWriter&);
+
+   Private::XmlWriteBuffer m_buffer;
+};
+
+class JsonWriter {
+public:
+   explicit JsonWriter(int indentation = 0) : m_buffer(indentation) {}
+
+   template <class ConcreteClass_>
+   const std::string& write(const ConcreteClass_& object) {
+      m_buffer.reset();
+      toWriteBuffer(object, m_buffer, 1);
+      return m_buffer.getOutput();
+   }
+
+private:
+   JsonWriter(const JsonWriter&);
+   JsonWriter& operator=(const JsonWriter&);
+
+   Private::JsonWriteBuffer m_buffer;
+};
+
 namespace Private {
 
    template <class ConcreteClass_>
    void serialize(const ConcreteClass_& object, AbstractWriteBuffer& buffer, int version, const Context& context) {
+      CTRL_INSTRUMENT_OBJECT(ConcreteClass_);
       buffer.enterObject(context);
       typedef typename ConcreteClass_::CTRL_BaseClasses BaseClasses;
       BaseClassSerializer<ConcreteClass_>::serialize(object, BaseClasses(), buffer, version, context);
@@ -94,32 +225,68 @@ namespace Private {
 
    template <size_t size_>
    void serialize(const std::bitset<size_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
-      const size_t nbChars = size_ / 8 + (size_ % 8 == 0 ? 0 : 1);
-      char bits[nbChars];
-      for (size_t i = 0; i < nbChars; ++i)
-         bits[i] = 0;
+      std::vector<char> bits(BitPacking::nbChars(size_));
+      BitPacking::pack(elements, bits.data());
+      buffer.appendBits(bits.data(), size_, context);
+   }
+
+   // Writes the elements of a random access collection. When the collection is
+   // large and its member is marked with CTRL_PARALLEL, chunks of elements are
+   // written to separate parts of the buffer on their own thread and appended in
+   // order. Each part has its own pointer ids, so ClassSerializer rejects such
+   // members at compile time when their elements can hold pointers. Whether the
+   // index is written only depends on the member and the size, so a collection
+   // nested in a part gets one too, with its chunks written on the current thread.
+   template <class Iterator_>
+   void serializeElements(Iterator_ first, Iterator_ last, AbstractWriteBuffer& buffer, int version, const Context& context) {
+      std::size_t size = last - first;
+      bool indexed = ParallelChunks::indexed(size, context);
+      std::size_t threads = buffer.isPart() ? 1 : ParallelChunks::threads(context);
+      std::size_t nbChunks = indexed ? ParallelChunks::indexedCount(size) : threads > 1 ? ParallelChunks::count(size, context) : 1;
+      std::vector<std::unique_ptr<AbstractWriteBuffer>> parts;
+      if (nbChunks > 1) {
+         for (std::size_t i = 0; i < nbChunks; ++i) {
+            parts.push_back(std::unique_ptr<AbstractWriteBuffer>(buffer.createPart()));
+         }
+      }
+      if (parts.empty() || !parts.front()) {
+         for (; first != last; ++first) {
+            buffer.nextCollectionElement(context);
+            serialize(*first, buffer, version, context);
+         }
+         return;
+      }
 
-      unsigned char mask = 0x80;
-      for (size_t i = 0; i < size_; ++i) {
-         if (elements[i])
-            bits[i / 8] = bits[i / 8] | mask;
-         if (mask == 0x01)
-            mask = 0x80;
-         else
-            mask = mask >> 1;
+      std::vector<SingleRoots> singleRoots(nbChunks);
+      std::vector<Context> contexts;
+      for (std::size_t i = 0; i < nbChunks; ++i) {
+         contexts.push_back(Context(context, singleRoots[i]));
+      }
+      ParallelChunks::run(nbChunks, threads, [&](std::size_t chunk) {
+         Iterator_ end = first + ParallelChunks::begin(size, nbChunks, chunk + 1);
+         for (Iterator_ iter = first + ParallelChunks::begin(size, nbChunks, chunk); iter != end; ++iter) {
+            parts[chunk]->nextCollectionElement(contexts[chunk]);
+            serialize(*iter, *parts[chunk], version, contexts[chunk]);
+         }
+      });
+      if (indexed) {
+         buffer.appendCollectionSize(nbChunks, context);
+         for (std::size_t i = 0; i < nbChunks; ++i) {
+            buffer.appendCollectionSize(ParallelChunks::begin(size, nbChunks, i + 1) - ParallelChunks::begin(size, nbChunks, i), context);
+            buffer.appendCollectionSize(buffer.partLength(*parts[i]), context);
+         }
+      }
+      for (std::size_t i = 0; i < nbChunks; ++i) {
+         buffer.appendPart(*parts[i]);
+         context.merge(singleRoots[i]);
       }
-      buffer.appendBits(bits, size_, context);
    }
 
    template <class Element_, class Alloc_>
    void serialize(const std::deque<Element_, Alloc_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
       buffer.enterCollection(context);
       buffer.appendCollectionSize(elements.size(), context);
-      for ( typename std::deque<Element_, Alloc_>::const_iterator iter = elements.begin();
-           iter != elements.end(); ++iter ) {
-         buffer.nextCollectionElement(context);
-         serialize(*iter, buffer, version, context);
-      }
+      serializeElements(elements.begin(), elements.end(), buffer, version, context);
       buffer.leaveCollection(context);
    }
 
@@ -171,28 +338,12 @@ namespace Private {
 
    template <class Element_, class Container_>
    void serialize(const std::queue<Element_, Container_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
-      std::queue<Element_, Container_> copy(elements);
-      buffer.enterCollection(context);
-      buffer.appendCollectionSize(copy.size(), context);
-      while (!copy.empty()) {
-         buffer.nextCollectionElement(context);
-         serialize(copy.front(), buffer, version, context);
-         copy.pop();
-      }
-      buffer.leaveCollection(context);
+      serialize(AdaptorContainer<std::queue<Element_, Container_> >::get(elements), buffer, version, context);
    }
 
    template <class Element_, class Container_, class Comp_>
    void serialize(const std::priority_queue<Element_, Container_, Comp_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
-      std::priority_queue<Element_, Container_, Comp_> copy(elements);
-      buffer.enterCollection(context);
-      buffer.appendCollectionSize(copy.size(), context);
-      while (!copy.empty()) {
-         buffer.nextCollectionElement(context);
-         serialize(copy.top(), buffer, version, context);
-         copy.pop();
-      }
-      buffer.leaveCollection(context);
+      serialize(AdaptorContainer<std::priority_queue<Element_, Container_, Comp_> >::get(elements), buffer, version, context);
    }
 
    template <class Key_, class Comp_, class Alloc_>
@@ -221,13 +372,13 @@ namespace Private {
 
    template <class Element_, class Container_>
    void serialize(const std::stack<Element_, Container_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
-      std::stack<Element_, Container_> copy(elements);
+      const Container_& container = AdaptorContainer<std::stack<Element_, Container_> >::get(elements);
       buffer.enterCollection(context);
-      buffer.appendCollectionSize(elements.size(), context);
-      while (!copy.empty()) {
+      buffer.appendCollectionSize(container.size(), context);
+      for ( typename Container_::const_reverse_iterator iter = container.rbegin();
+            iter != container.rend(); ++iter ) {
          buffer.nextCollectionElement(context);
-         serialize(copy.top(), buffer, version, context);
-         copy.pop();
+         serialize(*iter, buffer, version, context);
       }
       buffer.leaveCollection(context);
    }
@@ -236,11 +387,7 @@ namespace Private {
    void serialize(const std::vector<Element_, Alloc_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
       buffer.enterCollection(context);
       buffer.appendCollectionSize(elements.size(), context);
-      for ( typename std::vector<Element_, Alloc_>::const_iterator iter = elements.begin();
-           iter != elements.end(); ++iter ) {
-         buffer.nextCollectionElement(context);
-         serialize(*iter, buffer, version, context);
-      }
+      serializeElements(elements.begin(), elements.end(), buffer, version, context);
       buffer.leaveCollection(context);
    }
 
@@ -248,10 +395,7 @@ namespace Private {
    void serialize(const std::array<Element_, size_>& elements, AbstractWriteBuffer& buffer, int version, const Context& context) {
       buffer.enterCollection(context);
       buffer.appendCollectionSize(elements.size(), context);
-      for (typename std::array<Element_, size_>::const_iterator iter = elements.begin(); iter != elements.end(); ++iter) {
-         buffer.nextCollectionElement(context);
-         serialize(*iter, buffer, version, context);
-      }
+      serializeElements(elements.begin(), elements.end(), buffer, version, context);
       buffer.leaveCollection(context);
    }
 
@@ -576,6 +720,28 @@ namespace Private {
       buffer.leaveCollection(context);
    }
 
+   template <class Value_>
+   void serialize(const Cached<Value_>& cached, AbstractWriteBuffer& buffer, int version, const Context& context) {
+      EncodingCache& cache = cached.encodingCache();
+      if (cache.isValid(buffer, version)) {
+         buffer.appendPart(cache.encoding());
+         return;
+      }
+      std::unique_ptr<AbstractWriteBuffer> encoding(cache.isUncacheable() ? 0 : buffer.createCache());
+      if (!encoding) {
+         serialize(cached.get(), buffer, version, context);
+         return;
+      }
+      serialize(cached.get(), *encoding, version, context);
+      if (encoding->getPointerRepository().size() != 0) {
+         cache.setUncacheable();
+         serialize(cached.get(), buffer, version, context);
+         return;
+      }
+      buffer.appendPart(*encoding);
+      cache.store(encoding.release(), version);
+   }
+
    template <>
    void serialize(const bool& value, AbstractWriteBuffer& buffer, int version, const Context& context) {
       buffer.append(value, context);
@@ -646,9 +812,14 @@ namespace Private {
       buffer.append(value, context);
    }
 
+   template <>
+   void serialize(const ArenaString& value, AbstractWriteBuffer& buffer, int version, const Context& context) {
+      buffer.append(std::string(value.data(), value.length()), context);
+   }
+
    template <>
    void serialize(const std::wstring& value, AbstractWriteBuffer& buffer, int version, const Context& context) {
-      buffer.append(boost::locale::conv::utf_to_utf<char>(value), context);
+      buffer.append(value, context);
    }
 
 } // namespace Private
@@ -265,6 +265,17 @@ namespace Private {
 
 
 
+   template <class T_>
+   struct IsFloatingPoint { enum { value = false }; };
+
+   template <>
+   struct IsFloatingPoint<float> { enum { value = true }; };
+
+   template <>
+   struct IsFloatingPoint<double> { enum { value = true }; };
+
+
+
    template <class T_>
    struct IsPointer { enum { value = false }; };
 
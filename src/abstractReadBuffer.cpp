@@ -25,11 +25,12 @@
  */
 
 #include <ctrl/buffer/abstractReadBuffer.h>
+#include <ctrl/buffer/utfConvertor.h>
 
 using namespace ctrl;
 using namespace ctrl::Private;
 
-AbstractReadBuffer::AbstractReadBuffer() {
+AbstractReadBuffer::AbstractReadBuffer() : m_depth(0), m_allocated(0), m_inheritedAllocated(0) {
 
 }
 
@@ -49,3 +50,69 @@ ReadPointerRepository< boost::shared_ptr, boost::weak_ptr >& AbstractReadBuffer:
 ReadRawPointerRepository& AbstractReadBuffer::getRawPointerRepository() {
    return m_rawPointerRepository;
 }
+
+void AbstractReadBuffer::clearPointerRepositories() {
+   m_stdPointerRepository.clear();
+   m_boostPointerRepository.clear();
+   m_rawPointerRepository.clear();
+}
+
+void AbstractReadBuffer::setLimits(const Limits& limits) {
+   m_limits = limits;
+   resetLimitCounters();
+}
+
+void AbstractReadBuffer::resetLimitCounters() {
+   m_depth = 0;
+   m_allocated = 0;
+   m_inheritedAllocated = 0;
+}
+
+const Limits& AbstractReadBuffer::getLimits() const {
+   return m_limits;
+}
+
+void AbstractReadBuffer::inheritLimits(const AbstractReadBuffer& that) {
+   m_limits = that.m_limits;
+   m_depth = that.m_depth;
+   m_allocated = that.m_allocated;
+   m_inheritedAllocated = that.m_allocated;
+}
+
+std::size_t AbstractReadBuffer::reservableSize(std::size_t size, std::size_t minElementSize) const {
+   return size;
+}
+
+void AbstractReadBuffer::checkEncodedSize(std::size_t& size, std::size_t minElementSize) throw(Exception) {
+
+}
+
+bool AbstractReadBuffer::hasParts() const {
+   return false;
+}
+
+AbstractReadBuffer* AbstractReadBuffer::readPart(std::size_t length) throw(Exception) {
+   throw Exception("Buffer can't be read in parts");
+}
+
+void AbstractReadBuffer::leavePart() throw(Exception) {
+
+}
+
+bool AbstractReadBuffer::isPart() const {
+   return false;
+}
+
+void AbstractReadBuffer::leaveRoot() throw(Exception) {
+
+}
+
+std::size_t AbstractReadBuffer::position() const {
+   return 0;
+}
+
+void AbstractReadBuffer::read(std::wstring& val, const Context& context) throw(Exception) {
+   m_utf8.clear();
+   read(m_utf8, context);
+   UtfConvertor::assignWide(val, m_utf8.data(), m_utf8.data() + m_utf8.length());
+}
@@ -25,6 +25,7 @@
  */
 
 #include <ctrl/buffer/abstractWriteBuffer.h>
+#include <ctrl/buffer/utfConvertor.h>
 
 using namespace ctrl;
 using namespace ctrl::Private;
@@ -40,3 +41,45 @@ AbstractWriteBuffer::~AbstractWriteBuffer() {
 WritePointerRepository& AbstractWriteBuffer::getPointerRepository() {
    return m_pointerRepository;
 }
+
+void AbstractWriteBuffer::reset() {
+   m_pointerRepository.clear();
+}
+
+AbstractWriteBuffer* AbstractWriteBuffer::createPart() const {
+   return 0;
+}
+
+std::size_t AbstractWriteBuffer::partLength(AbstractWriteBuffer& part) const {
+   return 0;
+}
+
+void AbstractWriteBuffer::appendPart(AbstractWriteBuffer& part) throw(Exception) {
+   throw Exception("Buffer can't be written in parts");
+}
+
+bool AbstractWriteBuffer::isPart() const {
+   return false;
+}
+
+AbstractWriteBuffer* AbstractWriteBuffer::createCache() const {
+   return 0;
+}
+
+bool AbstractWriteBuffer::isSameFormat(const AbstractWriteBuffer& cache) const {
+   return false;
+}
+
+void AbstractWriteBuffer::shrinkToFit() {
+
+}
+
+std::size_t AbstractWriteBuffer::position() const {
+   return 0;
+}
+
+void AbstractWriteBuffer::append(const std::wstring& val, const Context& context) throw(Exception) {
+   m_utf8.clear();
+   UtfConvertor::appendUtf8(m_utf8, val);
+   append(m_utf8, context);
+}
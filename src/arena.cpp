@@ -0,0 +1,139 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/arena.h>
+#include <algorithm>
+#include <cstddef>
+
+using namespace ctrl;
+
+namespace {
+
+   thread_local Arena* s_current = 0;
+
+   const std::size_t maxAlignment = alignof(std::max_align_t);
+
+   std::size_t headerSize(std::size_t size) {
+      return (size + maxAlignment - 1) / maxAlignment * maxAlignment;
+   }
+
+} // namespace
+
+Arena::Arena(std::size_t blockSize)
+   : m_blocks(0)
+   , m_destructors(0)
+   , m_destructorCount(0)
+   , m_cursor(0)
+   , m_end(0)
+   , m_blockSize(blockSize)
+   , m_allocated(0) {
+
+}
+
+Arena::~Arena() {
+   runDestructors(0);
+   while (m_blocks != 0) {
+      Block* next = m_blocks->next;
+      ::operator delete(m_blocks);
+      m_blocks = next;
+   }
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment) {
+   std::size_t padding = (alignment - reinterpret_cast<std::size_t>(m_cursor) % alignment) % alignment;
+   if (m_cursor == 0 || static_cast<std::size_t>(m_end - m_cursor) < padding + size) {
+      addBlock(size + alignment);
+      padding = (alignment - reinterpret_cast<std::size_t>(m_cursor) % alignment) % alignment;
+   }
+   void* result = m_cursor + padding;
+   m_cursor += padding + size;
+   m_allocated += size;
+   return result;
+}
+
+void Arena::addDestructor(DestroyFunction destroy, void* object) {
+   Destructor* destructor = static_cast<Destructor*>(allocate(sizeof(Destructor), alignof(Destructor)));
+   destructor->next = m_destructors;
+   destructor->destroy = destroy;
+   destructor->object = object;
+   m_destructors = destructor;
+   ++m_destructorCount;
+}
+
+std::size_t Arena::destructorCount() const {
+   return m_destructorCount;
+}
+
+void Arena::runDestructors(std::size_t count) {
+   while (m_destructorCount > count) {
+      Destructor* destructor = m_destructors;
+      m_destructors = destructor->next;
+      --m_destructorCount;
+      destructor->destroy(destructor->object);
+   }
+}
+
+void Arena::reset() {
+   runDestructors(0);
+   if (m_blocks != 0) {
+      Block* next = m_blocks->next;
+      while (next != 0) {
+         Block* following = next->next;
+         ::operator delete(next);
+         next = following;
+      }
+      m_blocks->next = 0;
+      m_cursor = reinterpret_cast<char*>(m_blocks) + headerSize(sizeof(Block));
+      m_end = reinterpret_cast<char*>(m_blocks) + m_blocks->size;
+   }
+   m_allocated = 0;
+}
+
+std::size_t Arena::allocated() const {
+   return m_allocated;
+}
+
+Arena* Arena::current() {
+   return s_current;
+}
+
+void Arena::addBlock(std::size_t minimumSize) {
+   std::size_t size = headerSize(sizeof(Block)) + std::max(minimumSize, m_blockSize);
+   Block* block = static_cast<Block*>(::operator new(size));
+   block->next = m_blocks;
+   block->size = size;
+   m_blocks = block;
+   m_cursor = reinterpret_cast<char*>(block) + headerSize(sizeof(Block));
+   m_end = reinterpret_cast<char*>(block) + size;
+}
+
+ArenaScope::ArenaScope(Arena& arena) : m_previous(s_current) {
+   s_current = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+   s_current = m_previous;
+}
@@ -24,6 +24,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <ctrl/buffer/binaryReadBuffer.h>
 #include <ctrl/exception.h>
 #include <ctrl/context.h>
@@ -31,13 +32,41 @@
 using namespace ctrl;
 using namespace ctrl::Private;
 
-BinaryReadBuffer::Impl::Impl() { }
+BinaryReadBuffer::Impl::Impl() : m_recordErrors(false), m_failed(false), m_errorPosition(0) { }
 
 BinaryReadBuffer::Impl::~Impl() { }
 
+void BinaryReadBuffer::Impl::recordErrors() {
+   m_recordErrors = true;
+}
+
+bool BinaryReadBuffer::Impl::failed() const {
+   return m_failed;
+}
+
+std::size_t BinaryReadBuffer::Impl::errorPosition() const {
+   return m_errorPosition;
+}
+
+void BinaryReadBuffer::Impl::fail(std::size_t position) throw(Exception) {
+   if (!m_recordErrors) {
+      throw Exception("Input data is corrupt", position);
+   }
+   if (!m_failed) {
+      m_failed = true;
+      m_errorPosition = position;
+   }
+}
+
 BinaryReadBuffer::BinaryReadBuffer(BinaryReadBuffer::Impl* pimpl)
-   : m_pimpl(pimpl), m_skipNextFundamental(false) {
+   : m_pimpl(pimpl), m_skipNextFundamental(false), m_isPart(false) {
+   m_size = m_pimpl->remaining();
+}
 
+void BinaryReadBuffer::setInput(BinaryReadBuffer::Impl* pimpl) {
+   m_pimpl.reset(pimpl);
+   m_skipNextFundamental = false;
+   m_size = m_pimpl->remaining();
 }
 
 void BinaryReadBuffer::enterObject(const Context& context) throw(Exception) {
@@ -198,7 +227,66 @@ void BinaryReadBuffer::read(std::string& val, const Context& context) throw(Exce
    if (!m_skipNextFundamental) { m_pimpl->read(val); }
 }
 
+
+void BinaryReadBuffer::read(std::wstring& val, const Context& context) throw(Exception) {
+   if (!m_skipNextFundamental) { m_pimpl->read(val); }
+}
+
 bool BinaryReadBuffer::reachedEnd() const {
    return m_pimpl->reachedEnd();
 }
 
+std::size_t BinaryReadBuffer::remaining() const {
+   return m_pimpl->remaining();
+}
+
+void BinaryReadBuffer::recordErrors() {
+   m_pimpl->recordErrors();
+}
+
+bool BinaryReadBuffer::failed() const {
+   return m_pimpl->failed();
+}
+
+std::size_t BinaryReadBuffer::errorPosition() const {
+   return m_pimpl->errorPosition();
+}
+
+std::size_t BinaryReadBuffer::reservableSize(std::size_t size, std::size_t minElementSize) const {
+   return std::min(size, m_pimpl->remaining() / std::max(minElementSize, std::size_t(1)));
+}
+
+void BinaryReadBuffer::checkEncodedSize(std::size_t& size, std::size_t minElementSize) throw(Exception) {
+   if (m_pimpl->failed()) {
+      size = 0;
+   } else if (minElementSize != 0 && size > m_pimpl->remaining() / minElementSize) {
+      m_pimpl->failAtCursor();
+      size = 0;
+   }
+}
+
+bool BinaryReadBuffer::hasParts() const {
+   return true;
+}
+
+AbstractReadBuffer* BinaryReadBuffer::readPart(std::size_t length) throw(Exception) {
+   BinaryReadBuffer* part = new BinaryReadBuffer(m_pimpl->readPart(length));
+   part->m_isPart = true;
+   part->inheritLimits(*this);
+   return part;
+}
+
+void BinaryReadBuffer::leavePart() throw(Exception) {
+   if (!reachedEnd()) {
+      throw Exception("Input data is corrupt");
+   }
+}
+
+bool BinaryReadBuffer::isPart() const {
+   return m_isPart;
+}
+
+std::size_t BinaryReadBuffer::position() const {
+   return m_size - m_pimpl->remaining();
+}
+
@@ -24,6 +24,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <typeinfo>
 #include <ctrl/buffer/binaryWriteBuffer.h>
 #include <ctrl/context.h>
 #include <ctrl/properties.h>
@@ -54,6 +55,36 @@ char* BinaryWriteBuffer::Impl::getData() {
    return m_data;
 }
 
+const char* BinaryWriteBuffer::Impl::data() const {
+   return m_data;
+}
+
+void BinaryWriteBuffer::Impl::reset() {
+   if (!m_owner) {
+      m_data = new char[m_capacity];
+      m_owner = true;
+   }
+   m_length = 0;
+}
+
+void BinaryWriteBuffer::Impl::truncate(long length) {
+   m_length = length;
+}
+
+void BinaryWriteBuffer::Impl::shrinkToFit() {
+   long newCapacity = m_length > 0 ? m_length : 1;
+   if (!m_owner || newCapacity == m_capacity)
+      return;
+
+   char* newData = new char[newCapacity];
+   for (long i = 0; i < m_length; ++i)
+      newData[i] = m_data[i];
+
+   delete[] m_data;
+   m_data = newData;
+   m_capacity = newCapacity;
+}
+
 void BinaryWriteBuffer::Impl::appendNoPadding(const char* data, long length) {
    long newLength = m_length + length;
    if (newLength > m_capacity)
@@ -65,6 +96,20 @@ void BinaryWriteBuffer::Impl::appendNoPadding(const char* data, long length) {
    m_length += length;
 }
 
+char* BinaryWriteBuffer::Impl::appendUninitialized(long length) {
+   long newLength = m_length + length;
+   if (newLength > m_capacity)
+      realloc(newLength);
+
+   char* result = m_data + m_length;
+   m_length += length;
+   return result;
+}
+
+char* BinaryWriteBuffer::Impl::dataAt(long offset) {
+   return m_data + offset;
+}
+
 void BinaryWriteBuffer::Impl::realloc(long newLength) {
    long newCapacity = m_capacity * 10;
    while(newCapacity < newLength)
@@ -80,10 +125,14 @@ void BinaryWriteBuffer::Impl::realloc(long newLength) {
 }
 
 BinaryWriteBuffer::BinaryWriteBuffer(BinaryWriteBuffer::Impl* pimpl)
-   : m_pimpl(pimpl), m_skipNextFundamental(false) {
+   : m_pimpl(pimpl), m_skipNextFundamental(false), m_isPart(false) {
 
 }
 
+std::size_t BinaryWriteBuffer::position() const {
+   return m_pimpl->length();
+}
+
 long BinaryWriteBuffer::length() {
    return m_pimpl->length();
 }
@@ -92,6 +141,64 @@ char* BinaryWriteBuffer::getData() {
    return m_pimpl->getData();
 }
 
+const char* BinaryWriteBuffer::data() const {
+   return m_pimpl->data();
+}
+
+long BinaryWriteBuffer::appendSizePlaceholder() {
+   long offset = m_pimpl->length();
+   m_pimpl->append(std::size_t(0));
+   return offset;
+}
+
+void BinaryWriteBuffer::patchSize(long offset, const std::size_t& size) {
+   m_pimpl->overwrite(offset, size);
+}
+
+void BinaryWriteBuffer::truncate(long length) {
+   m_pimpl->truncate(length);
+}
+
+AbstractWriteBuffer* BinaryWriteBuffer::createPart() const {
+   BinaryWriteBuffer* part = new BinaryWriteBuffer(m_pimpl->createEmpty());
+   part->m_isPart = true;
+   return part;
+}
+
+std::size_t BinaryWriteBuffer::partLength(AbstractWriteBuffer& part) const {
+   return dynamic_cast<BinaryWriteBuffer&>(part).length();
+}
+
+void BinaryWriteBuffer::appendPart(AbstractWriteBuffer& part) throw(Exception) {
+   BinaryWriteBuffer& binaryPart = dynamic_cast<BinaryWriteBuffer&>(part);
+   m_pimpl->append(binaryPart.data(), binaryPart.length());
+}
+
+bool BinaryWriteBuffer::isPart() const {
+   return m_isPart;
+}
+
+AbstractWriteBuffer* BinaryWriteBuffer::createCache() const {
+   BinaryWriteBuffer* cache = new BinaryWriteBuffer(m_pimpl->createEmpty());
+   cache->m_isPart = m_isPart;
+   return cache;
+}
+
+bool BinaryWriteBuffer::isSameFormat(const AbstractWriteBuffer& cache) const {
+   const BinaryWriteBuffer* binaryCache = dynamic_cast<const BinaryWriteBuffer*>(&cache);
+   return binaryCache != 0 && typeid(*binaryCache->m_pimpl) == typeid(*m_pimpl);
+}
+
+void BinaryWriteBuffer::shrinkToFit() {
+   m_pimpl->shrinkToFit();
+}
+
+void BinaryWriteBuffer::reset() {
+   AbstractWriteBuffer::reset();
+   m_pimpl->reset();
+   m_skipNextFundamental = false;
+}
+
 void BinaryWriteBuffer::enterObject(const Context& context) throw(Exception) {
 
 }
@@ -251,3 +358,8 @@ void BinaryWriteBuffer::append(const double& val, const Context& context) throw(
 void BinaryWriteBuffer::append(const std::string& val, const Context& context) throw(Exception) {
    if (!m_skipNextFundamental) { m_pimpl->append(val); }
 }
+
+
+void BinaryWriteBuffer::append(const std::wstring& val, const Context& context) throw(Exception) {
+   if (!m_skipNextFundamental) { m_pimpl->append(val); }
+}
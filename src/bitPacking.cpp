@@ -0,0 +1,108 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/buffer/bitPacking.h>
+#include <cstdint>
+
+using namespace ctrl;
+using namespace ctrl::Private;
+
+namespace {
+
+   const char* hexDigits = "0123456789abcdef";
+
+   int hexValue(char c) {
+      if (c >= '0' && c <= '9')
+         return c - '0';
+      if (c >= 'a' && c <= 'f')
+         return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F')
+         return c - 'A' + 10;
+      return -1;
+   }
+
+   std::uint64_t reverseWord(std::uint64_t x) {
+      x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+      x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+      return ((x >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((x & 0x0f0f0f0f0f0f0f0fULL) << 4);
+   }
+
+} // namespace
+
+void BitPacking::reverseBits(const char* in, char* out, std::size_t nbChars) {
+   std::size_t i = 0;
+   for (; i + 8 <= nbChars; i += 8) {
+      std::uint64_t word;
+      std::memcpy(&word, in + i, 8);
+      word = reverseWord(word);
+      std::memcpy(out + i, &word, 8);
+   }
+   for (; i < nbChars; ++i) {
+      out[i] = static_cast<char>(reverseWord(static_cast<unsigned char>(in[i])));
+   }
+}
+
+void BitPacking::appendText(std::string& out, const char* data, std::size_t length) {
+   std::size_t size = nbChars(length);
+   std::size_t begin = out.size();
+   out.resize(begin + 2 + 2 * size);
+   char* p = &out[begin];
+   *p++ = '0';
+   *p++ = 'x';
+   for (std::size_t i = 0; i < size; ++i) {
+      unsigned char byte = static_cast<unsigned char>(data[i]);
+      p[2 * i] = hexDigits[byte >> 4];
+      p[2 * i + 1] = hexDigits[byte & 0x0f];
+   }
+}
+
+bool BitPacking::readText(const char* text, std::size_t textLength, char* data, std::size_t length) {
+   std::size_t size = nbChars(length);
+   if (textLength == 2 + 2 * size && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+      text += 2;
+      for (std::size_t i = 0; i < size; ++i) {
+         int high = hexValue(text[2 * i]);
+         int low = hexValue(text[2 * i + 1]);
+         if (high < 0 || low < 0) {
+            return false;
+         }
+         data[i] = static_cast<char>((high << 4) | low);
+      }
+      clearPadding(data, length);
+      return true;
+   } else if (textLength == length) {
+      std::memset(data, 0, size);
+      for (std::size_t i = 0; i < length; ++i) {
+         if (text[i] == '1') {
+            data[i >> 3] |= static_cast<char>(0x80 >> (i & 7));
+         } else if (text[i] != '0') {
+            return false;
+         }
+      }
+      return true;
+   }
+   return false;
+}
@@ -0,0 +1,226 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/instrumentation.h>
+
+#ifdef CTRL_INSTRUMENTATION
+
+#include <atomic>
+#include <mutex>
+#include <ctrl/buffer/abstractWriteBuffer.h>
+#include <ctrl/buffer/abstractReadBuffer.h>
+
+using namespace ctrl;
+using namespace ctrl::Private;
+
+namespace ctrl {
+
+namespace Private {
+
+   struct InstrumentationFrame {
+      Instrumentation::Call call;
+      AbstractWriteBuffer* writeBuffer;
+      AbstractReadBuffer* readBuffer;
+      Instrumentation::Counters* current;
+      std::size_t position;
+      unsigned long long allocations;
+      std::chrono::steady_clock::time_point start;
+   };
+
+} // namespace Private
+
+} // namespace ctrl
+
+namespace {
+
+   thread_local InstrumentationFrame* s_frame = 0;
+
+   std::atomic<Instrumentation::AllocationCounter> s_allocationCounter(0);
+
+   std::mutex s_mutex;
+   Instrumentation::Callback s_callback;
+   Instrumentation::Totals s_totals[2];
+
+   unsigned long long allocations() {
+      Instrumentation::AllocationCounter counter = s_allocationCounter.load(std::memory_order_relaxed);
+      return counter == 0 ? 0 : counter();
+   }
+
+   std::size_t position(const InstrumentationFrame& frame) {
+      return frame.writeBuffer != 0 ? frame.writeBuffer->position() : frame.readBuffer->position();
+   }
+
+   unsigned long long elapsed(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   InstrumentationFrame* begin(Instrumentation::Direction direction, const std::string& typeName,
+                               AbstractWriteBuffer* writeBuffer, AbstractReadBuffer* readBuffer) {
+      InstrumentationFrame* frame = new InstrumentationFrame();
+      frame->call.direction = direction;
+      frame->call.typeName = typeName;
+      frame->writeBuffer = writeBuffer;
+      frame->readBuffer = readBuffer;
+      frame->current = 0;
+      frame->position = position(*frame);
+      frame->allocations = allocations();
+      frame->start = std::chrono::steady_clock::now();
+      return frame;
+   }
+
+} // namespace
+
+Instrumentation::Counters::Counters()
+   : calls(0), objects(0), members(0), resolvedPointers(0), repositorySize(0), bytes(0), allocations(0),
+     nanoseconds(0) {
+
+}
+
+void Instrumentation::Counters::add(const Counters& that) {
+   calls += that.calls;
+   objects += that.objects;
+   members += that.members;
+   resolvedPointers += that.resolvedPointers;
+   repositorySize += that.repositorySize;
+   bytes += that.bytes;
+   allocations += that.allocations;
+   nanoseconds += that.nanoseconds;
+}
+
+void Instrumentation::setCallback(const Callback& callback) {
+   std::lock_guard<std::mutex> lock(s_mutex);
+   s_callback = callback;
+}
+
+void Instrumentation::setAllocationCounter(AllocationCounter counter) {
+   s_allocationCounter.store(counter, std::memory_order_relaxed);
+}
+
+Instrumentation::Totals Instrumentation::totals(Direction direction) {
+   std::lock_guard<std::mutex> lock(s_mutex);
+   return s_totals[direction];
+}
+
+void Instrumentation::reset() {
+   std::lock_guard<std::mutex> lock(s_mutex);
+   s_totals[Write] = Totals();
+   s_totals[Read] = Totals();
+}
+
+InstrumentedCall::InstrumentedCall(const std::string& typeName, AbstractWriteBuffer& buffer)
+   : m_frame(begin(Instrumentation::Write, typeName, &buffer, 0))
+   , m_previous(s_frame) {
+   s_frame = m_frame;
+}
+
+InstrumentedCall::InstrumentedCall(const std::string& typeName, AbstractReadBuffer& buffer)
+   : m_frame(begin(Instrumentation::Read, typeName, 0, &buffer))
+   , m_previous(s_frame) {
+   s_frame = m_frame;
+}
+
+InstrumentedCall::~InstrumentedCall() {
+   s_frame = m_previous;
+
+   Instrumentation::Counters& total = m_frame->call.total;
+   total.calls = 1;
+   total.bytes = position(*m_frame) - m_frame->position;
+   total.allocations = allocations() - m_frame->allocations;
+   total.nanoseconds = elapsed(m_frame->start);
+   if (m_frame->writeBuffer != 0) {
+      total.repositorySize = m_frame->writeBuffer->getPointerRepository().size();
+   } else {
+      total.repositorySize = m_frame->readBuffer->getStdPointerRepository().size() +
+                             m_frame->readBuffer->getBoostPointerRepository().size() +
+                             m_frame->readBuffer->getRawPointerRepository().size();
+   }
+
+   Instrumentation::Callback callback;
+   {
+      std::lock_guard<std::mutex> lock(s_mutex);
+      Instrumentation::Totals& totals = s_totals[m_frame->call.direction];
+      totals.calls[m_frame->call.typeName].add(total);
+      for (std::map<std::string, Instrumentation::Counters>::const_iterator iter = m_frame->call.types.begin();
+           iter != m_frame->call.types.end(); ++iter) {
+         totals.types[iter->first].add(iter->second);
+      }
+      callback = s_callback;
+   }
+   if (callback) {
+      try {
+         callback(m_frame->call);
+      }
+      catch (...) { }
+   }
+   delete m_frame;
+}
+
+InstrumentedObject::InstrumentedObject(const std::string& typeName)
+   : m_frame(s_frame)
+   , m_counters(0)
+   , m_outer(0)
+   , m_position(0)
+   , m_allocations(0) {
+   if (m_frame != 0) {
+      m_counters = &m_frame->call.types[typeName];
+      m_outer = m_frame->current;
+      m_frame->current = m_counters;
+      m_position = position(*m_frame);
+      m_allocations = allocations();
+      m_start = std::chrono::steady_clock::now();
+   }
+}
+
+InstrumentedObject::~InstrumentedObject() {
+   if (m_frame != 0) {
+      m_counters->objects += 1;
+      m_counters->bytes += position(*m_frame) - m_position;
+      m_counters->allocations += allocations() - m_allocations;
+      m_counters->nanoseconds += elapsed(m_start);
+      m_frame->call.total.objects += 1;
+      m_frame->current = m_outer;
+   }
+}
+
+void ctrl::Private::instrumentMember() {
+   if (s_frame != 0) {
+      s_frame->call.total.members += 1;
+      if (s_frame->current != 0) {
+         s_frame->current->members += 1;
+      }
+   }
+}
+
+void ctrl::Private::instrumentResolvedPointer() {
+   if (s_frame != 0) {
+      s_frame->call.total.resolvedPointers += 1;
+      if (s_frame->current != 0) {
+         s_frame->current->resolvedPointers += 1;
+      }
+   }
+}
+
+#endif // CTRL_INSTRUMENTATION
@@ -25,26 +25,112 @@
  */
 
 #include <ctrl/buffer/jsonReadBuffer.h>
-#include <ctrl/nlohmann/json.hpp>
+#include <ctrl/buffer/bitPacking.h>
 #include <ctrl/properties.h>
 
-using namespace nlohmann;
 using namespace ctrl;
 using namespace ctrl::Private;
 
-JsonReadBuffer::JsonReadBuffer(const std::string& data) : m_collectionStart(false),
-         m_mapStart(false),
-         m_skipNextFundamental(false),
-         m_keyStart(false) {
-   m_document = json::parse(data);
-   checkNonNull(m_document);
-   m_stack.push(&m_document);
+JsonReadBuffer::JsonReadBuffer(const std::string& data) : m_tokenizer(data.data(), data.data() + data.length()),
+         m_keyStart(false),
+         m_skipNextFundamental(false) {
+   if (m_tokenizer.isNull(m_tokenizer.begin())) {
+      throw ctrl::Exception("Corrupt data: no node with name '' found");
+   }
+   pushFrame(m_tokenizer.begin(), false);
+}
+
+void JsonReadBuffer::pushFrame(const char* value, bool fromFrontier) {
+   m_frames.push_back(Frame(value, fromFrontier, m_skipped.size()));
+}
+
+void JsonReadBuffer::popFrame() throw(Exception) {
+   Frame frame = m_frames.back();
+   m_frames.pop_back();
+   m_skipped.erase(m_skipped.begin() + frame.skippedBegin, m_skipped.end());
+   if (frame.fromFrontier) {
+      m_frames.back().cursor = nextEntry(frameEnd(frame));
+   }
+}
+
+const char* JsonReadBuffer::frameEnd(const Frame& frame) throw(Exception) {
+   if (frame.cursor != 0) {
+      return m_tokenizer.skipToClose(frame.cursor);
+   } else if (frame.end != 0) {
+      return frame.end;
+   }
+   return m_tokenizer.skipValue(frame.value);
+}
+
+void JsonReadBuffer::openFrame(Frame& frame) throw(Exception) {
+   if (frame.cursor == 0) {
+      const char* p = m_tokenizer.skipWhitespace(frame.value);
+      bool array = p != m_tokenizer.end() && *p == '[';
+      frame.cursor = m_tokenizer.skipWhitespace(m_tokenizer.expect(p, array ? '[' : '{'));
+   }
+}
+
+const char* JsonReadBuffer::nextEntry(const char* p) const throw(Exception) {
+   p = m_tokenizer.skipWhitespace(p);
+   if (p != m_tokenizer.end() && *p == ',') {
+      p = m_tokenizer.skipWhitespace(p + 1);
+      if (m_tokenizer.isClose(p)) {
+         return m_tokenizer.corrupt(p, "trailing comma");
+      }
+   }
+   return p;
+}
+
+// After a recorded error everything is read from the end of the text, where
+// loops over the entries of an object or array have to stop.
+bool JsonReadBuffer::atClose(const char* p) const {
+   return m_tokenizer.isClose(p) || m_tokenizer.failed();
 }
 
-void JsonReadBuffer::checkNonNull(const json& node, const std::string& name) {
-   if (node.is_null())  {
-      throw ctrl::Exception("Corrupt data: no node with name '" + name + "' found");
+const char* JsonReadBuffer::readKey(const char* p, const char*& key, const char*& keyEnd) throw(Exception) {
+   key = m_tokenizer.skipWhitespace(p);
+   const char* stringEnd = m_tokenizer.skipString(key);
+   if (m_tokenizer.failed()) {
+      key = keyEnd = m_tokenizer.end();
+      return m_tokenizer.end();
+   }
+   ++key;
+   keyEnd = stringEnd - 1;
+   return m_tokenizer.expect(stringEnd, ':');
+}
+
+const char* JsonReadBuffer::findMember(const std::string& name, bool& fromFrontier) throw(Exception) {
+   Frame& frame = m_frames.back();
+   openFrame(frame);
+   const char* key;
+   const char* keyEnd;
+   const char* value;
+
+   if (!atClose(frame.cursor)) {
+      value = readKey(frame.cursor, key, keyEnd);
+      if (m_tokenizer.keyEquals(key, keyEnd, name)) {
+         fromFrontier = true;
+         return value;
+      }
+   }
+
+   fromFrontier = false;
+   for (std::size_t i = frame.skippedBegin; i < m_skipped.size(); ++i) {
+      if (m_tokenizer.keyEquals(m_skipped[i].key, m_skipped[i].keyEnd, name)) {
+         return m_skipped[i].value;
+      }
    }
+
+   while (!atClose(frame.cursor)) {
+      value = readKey(frame.cursor, key, keyEnd);
+      if (m_tokenizer.keyEquals(key, keyEnd, name)) {
+         fromFrontier = true;
+         return value;
+      }
+      m_skipped.push_back(SkippedMember(key, keyEnd, value));
+      frame.cursor = nextEntry(m_tokenizer.skipValue(value));
+   }
+   return 0;
 }
 
 void JsonReadBuffer::enterObject(const Context& context) throw(Exception) {
@@ -60,9 +146,14 @@ void JsonReadBuffer::enterMember(const Context& context, const char* suggested)
       }
       m_skipNextFundamental = true;
    } else {
-      json& node = (*m_stack.top())[name];
-      checkNonNull(node, name);
-      m_stack.push(&node);
+      bool fromFrontier;
+      const char* value = findMember(name, fromFrontier);
+      // Non-finite floating point values are written as null.
+      if (value == 0 || (m_tokenizer.isNull(value) && !context.getOwningMember().isFloatingPoint())) {
+         value = m_tokenizer.fail(m_tokenizer.skipWhitespace(m_frames.back().value),
+                                  "Corrupt data: no node with name '" + name + "' found");
+      }
+      pushFrame(value, fromFrontier);
    }
 }
 
@@ -70,7 +161,7 @@ void JsonReadBuffer::leaveMember(const Context& context) throw(Exception) {
    if (m_skipNextFundamental) {
       m_skipNextFundamental = false;
    } else {
-      m_stack.pop();
+      popFrame();
    }
 }
 
@@ -86,49 +177,47 @@ void JsonReadBuffer::enterIdField(const Context& context) throw(Exception) {
    } else {
       name = m_util.preferedMemberName(idFieldContext);
    }
-   json& node = (*m_stack.top())[name];
-   m_stack.push(&node);
+   bool fromFrontier;
+   const char* value = findMember(name, fromFrontier);
+   pushFrame(value, value != 0 && fromFrontier);
 }
 
 bool JsonReadBuffer::isNullId(const Context& context) throw(Exception) {
-   return m_stack.top()->is_null();
+   const char* value = m_frames.back().value;
+   return value == 0 || m_tokenizer.isNull(value);
 }
 
 void JsonReadBuffer::leaveIdField(const Context& context) throw(Exception) {
-   m_stack.pop();
+   popFrame();
 }
 
 void JsonReadBuffer::enterCollection(const Context& context) throw(Exception) {
-   m_collectionStart = true;
+   m_frames.back().iterating = true;
 }
 
 void JsonReadBuffer::enterMap(const Context& context) throw(Exception) {
    if (!context.getOwningMember().isMapKeyFundamental()) {
       throw Exception("Only fundamental map keys allowed when serializing to JSON");
    }
-   m_mapStart = true;
+   m_frames.back().iterating = true;
 }
 
 void JsonReadBuffer::nextCollectionElement(const Context& context) throw(Exception) {
-   if (m_collectionStart || m_mapStart) {
-      if (m_mapStart) {
-         m_keyValue = m_stack.top()->begin().key();
-      }
-      m_iterStack.push(m_stack.top()->begin());
-      m_stack.push(&(*m_stack.top()->begin()));
-      m_collectionStart = false;
-      m_mapStart = false;
-   } else {
-      json* prev = m_stack.top();
-      m_stack.pop();
-      json::iterator next = ++m_iterStack.top();
-      m_iterStack.pop();
-      m_iterStack.push(next);
-      if (m_stack.top()->is_object()) {
-         m_keyValue = next.key();
-      }
-      m_stack.push(&*next);
+   if (!m_frames.back().iterating) {
+      popFrame();
    }
+   Frame& frame = m_frames.back();
+   openFrame(frame);
+   const char* value = frame.cursor;
+   if (atClose(value)) {
+      value = m_tokenizer.fail(value, "Corrupt data: collection contains less elements than expected");
+   } else if (*m_tokenizer.skipWhitespace(frame.value) == '{') {
+      const char* key;
+      const char* keyEnd;
+      value = readKey(frame.cursor, key, keyEnd);
+      m_tokenizer.unescape(key, keyEnd, m_keyValue);
+   }
+   pushFrame(value, true);
 }
 
 void JsonReadBuffer::enterKey(const Context& context) throw(Exception) {
@@ -148,21 +237,17 @@ void JsonReadBuffer::leaveValue(const Context& context) throw(Exception) {
 }
 
 void JsonReadBuffer::leaveCollection(const Context& context) throw(Exception) {
-   if (m_collectionStart) {
-      m_collectionStart = false;
-   } else {
-      m_stack.pop();
-      m_iterStack.pop();
+   if (!m_frames.back().iterating) {
+      popFrame();
    }
+   m_frames.back().iterating = false;
 }
 
 void JsonReadBuffer::leaveMap(const Context& context) throw(Exception) {
-   if (m_mapStart) {
-      m_mapStart = false;
-   } else {
-      m_stack.pop();
-      m_iterStack.pop();
+   if (!m_frames.back().iterating) {
+      popFrame();
    }
+   m_frames.back().iterating = false;
 }
 
 void JsonReadBuffer::readVersion(int& version, const Context& context) throw(Exception) {
@@ -172,91 +257,145 @@ void JsonReadBuffer::readVersion(int& version, const Context& context) throw(Exc
 void JsonReadBuffer::readBits(char* data, long int length, const Context& context) throw(Exception) {
    if (!m_skipNextFundamental) {
       std::string bits;
-      readNode(m_stack.top(), bits);
-      if (bits.length() != length) {
-         throw ctrl::Exception("Number of bits doesn't match");
-      }
-
-      size_t nbChars = length / 8 + (length % 8 == 0 ? 0 : 1);
-      for (size_t i = 0; i < nbChars; ++i)
-         data[i] = 0;
-
-      unsigned char mask = 0x80;
-      for (size_t i = 0; i < length; ++i) {
-         if (bits.substr(i, 1) == "1")
-            data[i / 8] = data[i / 8] | mask;
-         if (mask == 0x01)
-            mask = 0x80;
-         else
-            mask = mask >> 1;
+      readNode(bits);
+      if (!BitPacking::readText(bits.data(), bits.length(), data, length)) {
+         m_frames.back().end = m_tokenizer.fail(m_tokenizer.skipWhitespace(m_frames.back().value),
+                                                "Number of bits doesn't match");
       }
    }
 }
 
 void JsonReadBuffer::readCollectionSize(std::size_t& size, const Context& context) throw(Exception) {
-   json& node = *m_stack.top();
-   size = node.size();
+   Frame& frame = m_frames.back();
+   openFrame(frame);
+   size = m_tokenizer.countEntries(frame.cursor, *m_tokenizer.skipWhitespace(frame.value) == '{');
 }
 
 void JsonReadBuffer::readTypeId(std::string& val, const Context& context) throw(Exception) {
    std::string field = context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>();
-   json& node = (*m_stack.top())[field];
-   checkNonNull(node, field);
-   val = node.get<std::string>();
+   bool fromFrontier;
+   const char* value = findMember(field, fromFrontier);
+   if (value == 0 || m_tokenizer.isNull(value)) {
+      value = m_tokenizer.fail(m_tokenizer.skipWhitespace(m_frames.back().value),
+                               "Corrupt data: no node with name '" + field + "' found");
+   }
+   pushFrame(value, fromFrontier);
+   readValue(val);
+   popFrame();
+}
+
+void JsonReadBuffer::readValue(bool& val) {
+   Frame& frame = m_frames.back();
+   frame.end = m_tokenizer.readBool(frame.value, val);
+}
+
+void JsonReadBuffer::readValue(char& val) {
+   readValue(m_stringValue);
+   val = m_stringValue.c_str()[0];
+}
+
+void JsonReadBuffer::readValue(float& val) {
+   Frame& frame = m_frames.back();
+   frame.end = m_tokenizer.readFloat(frame.value, val);
+}
+
+void JsonReadBuffer::readValue(double& val) {
+   Frame& frame = m_frames.back();
+   frame.end = m_tokenizer.readDouble(frame.value, val);
+}
+
+void JsonReadBuffer::readValue(std::string& val) {
+   Frame& frame = m_frames.back();
+   frame.end = m_tokenizer.readString(frame.value, val);
 }
 
 void JsonReadBuffer::read(bool& val, const Context& context) throw(Exception) {
-   readNode(m_stack.top(), val);
+   readNode(val);
 }
 
 void JsonReadBuffer::read(char& val, const Context& context) throw(Exception) {
-   readNode(m_stack.top(), val);
+   readNode(val);
 }
 
 void JsonReadBuffer::read(short& val, const Context& context) throw(Exception) {
-   readNode<short>(m_stack.top(), val);
+   readNode<short>(val);
 }
 
 void JsonReadBuffer::read(int& val, const Context& context) throw(Exception) {
-   readNode<int>(m_stack.top(), val);
+   readNode<int>(val);
 }
 
 void JsonReadBuffer::read(long& val, const Context& context) throw(Exception) {
-   readNode<long>(m_stack.top(), val);
+   readNode<long>(val);
 }
 
 void JsonReadBuffer::read(long long& val, const Context& context) throw(Exception) {
-   readNode<long long>(m_stack.top(), val);
+   readNode<long long>(val);
 }
 
 void JsonReadBuffer::read(unsigned char& val, const Context& context) throw(Exception) {
-   readNode<unsigned char>(m_stack.top(), val);
+   readNode<unsigned char>(val);
 }
 
 void JsonReadBuffer::read(unsigned short& val, const Context& context) throw(Exception) {
-   readNode<unsigned short>(m_stack.top(), val);
+   readNode<unsigned short>(val);
 }
 
 void JsonReadBuffer::read(unsigned int& val, const Context& context) throw(Exception) {
-   readNode<unsigned int>(m_stack.top(), val);
+   readNode<unsigned int>(val);
 }
 
 void JsonReadBuffer::read(unsigned long& val, const Context& context) throw(Exception) {
-   readNode<unsigned long>(m_stack.top(), val);
+   readNode<unsigned long>(val);
 }
 
 void JsonReadBuffer::read(unsigned long long& val, const Context& context) throw(Exception) {
-   readNode<unsigned long long>(m_stack.top(), val);
+   readNode<unsigned long long>(val);
 }
 
 void JsonReadBuffer::read(float& val, const Context& context) throw(Exception) {
-   readNode<float>(m_stack.top(), val);
+   readNode<float>(val);
 }
 
 void JsonReadBuffer::read(double& val, const Context& context) throw(Exception) {
-   readNode<double>(m_stack.top(), val);
+   readNode<double>(val);
 }
 
 void JsonReadBuffer::read(std::string& val, const Context& context) throw(Exception) {
-   readNode(m_stack.top(), val);
+   readNode(val);
+}
+
+// Skips what is left of the root value, which checks it as far as skipping
+// does, and only allows white space after it.
+void JsonReadBuffer::leaveRoot() throw(Exception) {
+   const char* end = m_tokenizer.skipWhitespace(frameEnd(m_frames.front()));
+   if (end != m_tokenizer.end()) {
+      m_tokenizer.corrupt(end, "unexpected data after the root value");
+   }
+}
+
+void JsonReadBuffer::recordErrors() {
+   m_tokenizer.recordErrors();
+}
+
+bool JsonReadBuffer::failed() const {
+   return m_tokenizer.failed();
+}
+
+const std::string& JsonReadBuffer::errorReason() const {
+   return m_tokenizer.errorReason();
+}
+
+std::size_t JsonReadBuffer::errorPosition() const {
+   return m_tokenizer.errorPosition();
+}
+
+// Members that are read out of order make this an approximation: the position
+// is the point up to which the innermost value has been scanned.
+std::size_t JsonReadBuffer::position() const {
+   if (m_frames.empty()) {
+      return m_tokenizer.end() - m_tokenizer.begin();
+   }
+   const Frame& frame = m_frames.back();
+   return (frame.cursor != 0 ? frame.cursor : frame.value) - m_tokenizer.begin();
 }
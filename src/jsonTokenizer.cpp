@@ -0,0 +1,383 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/buffer/jsonTokenizer.h>
+#include <ctrl/buffer/bufferUtil.h>
+#include <ctrl/buffer/numberFormat.h>
+#include <ctrl/buffer/utfConvertor.h>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include <algorithm>
+
+using namespace ctrl;
+using namespace ctrl::Private;
+
+JsonTokenizer::JsonTokenizer(const char* begin, const char* end) : m_begin(begin), m_end(end),
+         m_recordErrors(false),
+         m_failed(false),
+         m_errorPosition(0) {
+
+}
+
+const char* JsonTokenizer::begin() const {
+   return m_begin;
+}
+
+const char* JsonTokenizer::end() const {
+   return m_end;
+}
+
+void JsonTokenizer::recordErrors() {
+   m_recordErrors = true;
+}
+
+bool JsonTokenizer::failed() const {
+   return m_failed;
+}
+
+const std::string& JsonTokenizer::errorReason() const {
+   return m_errorReason;
+}
+
+std::size_t JsonTokenizer::errorPosition() const {
+   return m_errorPosition;
+}
+
+const char* JsonTokenizer::corrupt(const char* p, const std::string& reason) const throw(Exception) {
+   return fail(p, "Corrupt data: " + reason + " (offset: " + std::to_string(p - m_begin) + ")");
+}
+
+const char* JsonTokenizer::fail(const char* p, const std::string& message) const throw(Exception) {
+   if (!m_recordErrors) {
+      throw Exception(message, p - m_begin);
+   }
+   if (!m_failed) {
+      m_failed = true;
+      m_errorReason = message;
+      m_errorPosition = p - m_begin;
+   }
+   return m_end;
+}
+
+const char* JsonTokenizer::skipWhitespace(const char* p) const {
+   while (p < m_end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+      ++p;
+   return p;
+}
+
+const char* JsonTokenizer::expect(const char* p, char c) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (p == m_end || *p != c) {
+      return corrupt(p, std::string("expected '") + c + "'");
+   }
+   return p + 1;
+}
+
+bool JsonTokenizer::isNull(const char* p) const {
+   p = skipWhitespace(p);
+   return m_end - p >= 4 && std::memcmp(p, "null", 4) == 0;
+}
+
+bool JsonTokenizer::isClose(const char* p) const {
+   return p < m_end && (*p == '}' || *p == ']');
+}
+
+const char* JsonTokenizer::skipString(const char* p) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (p == m_end || *p != '"') {
+      return corrupt(p, "expected string");
+   }
+   ++p;
+   while (p < m_end) {
+      if (*p == '"') {
+         return p + 1;
+      } else if (*p == '\\') {
+         p += 2;
+      } else {
+         ++p;
+      }
+   }
+   return corrupt(std::min(p, m_end), "unterminated string");
+}
+
+// Only checks that strings are terminated, brackets are balanced and no comma
+// comes right before a closing bracket.
+const char* JsonTokenizer::skipToClose(const char* p) const throw(Exception) {
+   int depth = 1;
+   char last = 0;
+   while (p < m_end) {
+      switch (*p) {
+      case '"':
+         p = skipString(p);
+         last = '"';
+         break;
+      case '{':
+      case '[':
+         ++depth;
+         last = *p++;
+         break;
+      case '}':
+      case ']':
+         if (last == ',') {
+            return corrupt(p, "trailing comma");
+         }
+         last = *p++;
+         if (--depth == 0) {
+            return p;
+         }
+         break;
+      case ' ':
+      case '\n':
+      case '\r':
+      case '\t':
+         ++p;
+         break;
+      default:
+         last = *p++;
+      }
+   }
+   return corrupt(p, "unterminated object or array");
+}
+
+const char* JsonTokenizer::skipValue(const char* p) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (p == m_end) {
+      return corrupt(p, "expected value");
+   }
+   switch (*p) {
+   case '"':
+      return skipString(p);
+   case '{':
+   case '[':
+      return skipToClose(p + 1);
+   case 't':
+   case 'f': {
+      bool val;
+      return readBool(p, val);
+   }
+   case 'n':
+      if (isNull(p)) {
+         return p + 4;
+      }
+   default: {
+      // numbers, including nan and inf
+      const char* start = p;
+      while (p < m_end && (std::isalnum(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.'))
+         ++p;
+      if (p == start) {
+         return corrupt(p, "expected value");
+      }
+      return p;
+   }
+   }
+}
+
+std::size_t JsonTokenizer::countEntries(const char* p, bool object) const throw(Exception) {
+   std::size_t count = 0;
+   p = skipWhitespace(p);
+   if (isClose(p)) {
+      return 0;
+   }
+   while (true) {
+      if (object) {
+         p = expect(skipString(p), ':');
+      }
+      p = skipWhitespace(skipValue(p));
+      ++count;
+      if (p < m_end && *p == ',') {
+         ++p;
+      } else if (isClose(p)) {
+         return count;
+      } else {
+         corrupt(p, "expected ',' or closing bracket");
+         return count;
+      }
+   }
+}
+
+const char* JsonTokenizer::readString(const char* p, std::string& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   const char* stringEnd = skipString(p);
+   if (stringEnd == m_end && m_failed) {
+      val.clear();
+      return stringEnd;
+   }
+   unescape(p + 1, stringEnd - 1, val);
+   return stringEnd;
+}
+
+const char* JsonTokenizer::readBool(const char* p, bool& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (m_end - p >= 4 && std::memcmp(p, "true", 4) == 0) {
+      val = true;
+      return p + 4;
+   } else if (m_end - p >= 5 && std::memcmp(p, "false", 5) == 0) {
+      val = false;
+      return p + 5;
+   }
+   val = false;
+   return corrupt(p, "expected boolean");
+}
+
+const char* JsonTokenizer::readInteger(const char* p, long long& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   const char* end = NumberFormat::parse(p, m_end, val);
+   if (end != 0 && end != m_end && (*end == '.' || *end == 'e' || *end == 'E')) {
+      double d;
+      end = readDouble(p, d);
+      val = static_cast<long long>(d);
+   } else if (end == 0) {
+      val = 0;
+      return corrupt(p, "expected integer");
+   }
+   return end;
+}
+
+const char* JsonTokenizer::readUnsigned(const char* p, unsigned long long& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   const char* end = NumberFormat::parse(p, m_end, val);
+   if (end != 0 && end != m_end && (*end == '.' || *end == 'e' || *end == 'E')) {
+      double d;
+      end = readDouble(p, d);
+      val = static_cast<unsigned long long>(d);
+   } else if (end == 0) {
+      val = 0;
+      return corrupt(p, "expected unsigned integer");
+   }
+   return end;
+}
+
+const char* JsonTokenizer::readDouble(const char* p, double& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (isNull(p)) {
+      val = std::numeric_limits<double>::quiet_NaN();
+      return p + 4;
+   }
+   const char* end = NumberFormat::parse(p, m_end, val);
+   if (end == 0) {
+      val = 0;
+      return corrupt(p, "expected number");
+   }
+   return end;
+}
+
+const char* JsonTokenizer::readFloat(const char* p, float& val) const throw(Exception) {
+   p = skipWhitespace(p);
+   if (isNull(p)) {
+      val = std::numeric_limits<float>::quiet_NaN();
+      return p + 4;
+   }
+   const char* end = NumberFormat::parse(p, m_end, val);
+   if (end == 0) {
+      val = 0;
+      return corrupt(p, "expected number");
+   }
+   return end;
+}
+
+bool JsonTokenizer::keyEquals(const char* key, const char* keyEnd, const std::string& name) const {
+   std::size_t length = keyEnd - key;
+   if (std::memchr(key, '\\', length) == 0) {
+      return length == name.length() && std::memcmp(key, name.data(), length) == 0;
+   }
+   std::string unescaped;
+   unescape(key, keyEnd, unescaped);
+   return unescaped == name;
+}
+
+namespace {
+
+   unsigned int readHex(const char* p) {
+      unsigned int val = 0;
+      for (int i = 0; i < 4; ++i) {
+         char c = p[i];
+         val <<= 4;
+         if (c >= '0' && c <= '9') {
+            val |= c - '0';
+         } else if (c >= 'a' && c <= 'f') {
+            val |= c - 'a' + 10;
+         } else if (c >= 'A' && c <= 'F') {
+            val |= c - 'A' + 10;
+         } else {
+            return 0xffffffff;
+         }
+      }
+      return val;
+   }
+
+} // namespace
+
+void JsonTokenizer::unescape(const char* p, const char* stringEnd, std::string& val) const throw(Exception) {
+   val.clear();
+   while (p < stringEnd) {
+      const char* escape = reinterpret_cast<const char*>(std::memchr(p, '\\', stringEnd - p));
+      if (escape == 0) {
+         val.append(p, stringEnd);
+         return;
+      }
+      val.append(p, escape);
+      p = escape + 1;
+      if (p == stringEnd) {
+         corrupt(p, "invalid escape sequence");
+         return;
+      }
+      switch (*p) {
+      case '"':  val += '"';  break;
+      case '\\': val += '\\'; break;
+      case '/':  val += '/';  break;
+      case 'b':  val += '\b'; break;
+      case 'f':  val += '\f'; break;
+      case 'n':  val += '\n'; break;
+      case 'r':  val += '\r'; break;
+      case 't':  val += '\t'; break;
+      case 'u': {
+         unsigned int code = stringEnd - p > 4 ? readHex(p + 1) : 0xffffffff;
+         if (code == 0xffffffff) {
+            corrupt(p, "invalid unicode escape");
+            return;
+         }
+         p += 4;
+         if (code >= 0xd800 && code <= 0xdbff && stringEnd - p > 6 && p[1] == '\\' && p[2] == 'u') {
+            unsigned int low = readHex(p + 3);
+            if (low >= 0xdc00 && low <= 0xdfff) {
+               code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+               p += 6;
+            }
+         }
+         if (!UtfConvertor::appendCodePoint(val, code)) {
+            corrupt(p, "invalid unicode escape");
+            return;
+         }
+         break;
+      }
+      default:
+         corrupt(p, "invalid escape sequence");
+         return;
+      }
+      ++p;
+   }
+}
@@ -24,12 +24,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <climits>
 #include <ctrl/buffer/jsonWriteBuffer.h>
-#include <ctrl/nlohmann/json.hpp>
+#include <ctrl/buffer/bitPacking.h>
 #include <ctrl/properties.h>
 
-using namespace nlohmann;
 using namespace ctrl;
 using namespace ctrl::Private;
 
@@ -38,8 +36,104 @@ JsonWriteBuffer::JsonWriteBuffer(int indentation) : m_collectionStart(false),
          m_keyStart(false),
          m_skipNextFundamental(false),
          m_indentation(indentation) {
-   m_document = json();
-   m_stack.push(&m_document);
+   m_frames.push_back(Frame());
+}
+
+void JsonWriteBuffer::openObject() {
+   Frame& frame = m_frames.back();
+   if (frame.state == Empty) {
+      m_output.push_back('{');
+      frame.state = Object;
+   }
+}
+
+void JsonWriteBuffer::beginEntry() {
+   Frame& frame = m_frames.back();
+   if (frame.entries++ > 0) {
+      m_output.push_back(',');
+   }
+   if (m_indentation > 0) {
+      m_output.push_back('\n');
+      m_output.append(m_frames.size() * m_indentation, ' ');
+   }
+}
+
+void JsonWriteBuffer::writeKey(const std::string& key) {
+   beginEntry();
+   m_output.push_back('"');
+   appendEscaped(key);
+   m_output.append(m_indentation > 0 ? "\": " : "\":");
+   m_frames.push_back(Frame());
+}
+
+void JsonWriteBuffer::writeMapKey(const std::string& key) {
+   Frame& map = m_frames.back();
+   if (map.entries > 0 && m_keys.compare(map.keyBegin, std::string::npos, key) == 0) {
+      throw Exception("Multimaps with duplicated keys aren't supported when serializing to JSON");
+   }
+   m_keys.resize(map.keyBegin);
+   m_keys.append(key);
+   writeKey(key);
+}
+
+void JsonWriteBuffer::writeScalar(const char* begin, const char* end) {
+   Frame& frame = m_frames.back();
+   if (frame.state == Empty) {
+      m_output.append(begin, end);
+      frame.state = Done;
+   }
+}
+
+void JsonWriteBuffer::writeString(const std::string& val) {
+   Frame& frame = m_frames.back();
+   if (frame.state == Empty) {
+      m_output.push_back('"');
+      appendEscaped(val);
+      m_output.push_back('"');
+      frame.state = Done;
+   }
+}
+
+void JsonWriteBuffer::closeFrame(Frame& frame) {
+   if (frame.state == Empty) {
+      m_output.append("{}");
+   } else if (frame.state == Object || frame.state == Array) {
+      if (m_indentation > 0 && frame.entries > 0) {
+         m_output.push_back('\n');
+         m_output.append((m_frames.size() - 1) * m_indentation, ' ');
+      }
+      m_output.push_back(frame.state == Object ? '}' : ']');
+   }
+   frame.state = Done;
+}
+
+void JsonWriteBuffer::popFrame() {
+   closeFrame(m_frames.back());
+   m_frames.pop_back();
+}
+
+void JsonWriteBuffer::appendEscaped(const std::string& val) {
+   static const char* hex = "0123456789abcdef";
+   for (std::string::const_iterator it = val.begin(); it != val.end(); ++it) {
+      unsigned char c = static_cast<unsigned char>(*it);
+      switch (c) {
+         case '"': m_output.append("\\\""); break;
+         case '\\': m_output.append("\\\\"); break;
+         case '\b': m_output.append("\\b"); break;
+         case '\f': m_output.append("\\f"); break;
+         case '\n': m_output.append("\\n"); break;
+         case '\r': m_output.append("\\r"); break;
+         case '\t': m_output.append("\\t"); break;
+         default:
+            if (c < 0x20) {
+               m_output.append("\\u00");
+               m_output.push_back(hex[c >> 4]);
+               m_output.push_back(hex[c & 0x0f]);
+            } else {
+               m_output.push_back(*it);
+            }
+      }
+   }
 }
 
 void JsonWriteBuffer::enterObject(const Context& context) throw(Exception) {
@@ -55,8 +149,8 @@ void JsonWriteBuffer::enterMember(const Context& context, const char* suggested)
       }
       m_skipNextFundamental = true;
    } else {
-      (*m_stack.top())[name] = json();
-      m_stack.push(&(*m_stack.top())[name]);
+      openObject();
+      writeKey(name);
    }
 }
 
@@ -64,7 +158,7 @@ void JsonWriteBuffer::leaveMember(const Context& context) throw(Exception) {
    if (context.getOwningMember().getProperty<ctrl::AsIdField>()) {
       m_skipNextFundamental = false;
    } else {
-      m_stack.pop();
+      popFrame();
    }
 }
 
@@ -80,12 +174,13 @@ void JsonWriteBuffer::enterIdField(const Context& context) throw(Exception) {
    } else {
       name = m_util.preferedMemberName(idFieldContext);
    }
-   (*m_stack.top())[name] = json();
-   m_stack.push(&(*m_stack.top())[name]);
+   openObject();
+   writeKey(name);
 }
 
 void JsonWriteBuffer::appendNullId(const Context& context) throw(Exception) {
-   (*m_stack.top()) = nullptr;
+   static const char null[] = "null";
+   writeScalar(null, null + 4);
 }
 
 void JsonWriteBuffer::appendNonNullId(const Context& context) throw(Exception) {
@@ -93,10 +188,12 @@ void JsonWriteBuffer::appendNonNullId(const Context& context) throw(Exception) {
 }
 
 void JsonWriteBuffer::leaveIdField(const Context& context) throw(Exception) {
-   m_stack.pop();
+   popFrame();
 }
 
 void JsonWriteBuffer::enterCollection(const Context& context) throw(Exception) {
+   m_output.push_back('[');
+   m_frames.back().state = Array;
    m_collectionStart = true;
 }
 
@@ -104,6 +201,9 @@ void JsonWriteBuffer::enterMap(const Context& context) throw(Exception) {
    if (!context.getOwningMember().isMapKeyFundamental()) {
       throw Exception("Only fundamental map keys allowed when serializing to JSON");
    }
+   m_output.push_back('{');
+   m_frames.back().state = Object;
+   m_frames.back().keyBegin = m_keys.size();
    m_mapStart = true;
 }
 
@@ -111,11 +211,11 @@ void JsonWriteBuffer::nextCollectionElement(const Context& context) throw(Except
    if (m_collectionStart) {
       m_collectionStart = false;
    } else if (!m_mapStart) {
-      m_stack.pop();
+      popFrame();
    }
-   if (!m_mapStart && !m_stack.top()->is_object()) {
-      m_stack.top()->push_back(json());
-      m_stack.push(&(*m_stack.top())[m_stack.top()->size() - 1]);
+   if (!m_mapStart && m_frames.back().state == Array) {
+      beginEntry();
+      m_frames.push_back(Frame());
    } else {
       m_mapStart = false;
    }
@@ -140,19 +240,20 @@ void JsonWriteBuffer::leaveValue(const Context& context) throw(Exception) {
 void JsonWriteBuffer::leaveCollection(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
-      (*m_stack.top()) = json::array();
    } else {
-      m_stack.pop();
+      popFrame();
    }
+   closeFrame(m_frames.back());
 }
 
 void JsonWriteBuffer::leaveMap(const Context& context) throw(Exception) {
    if (m_mapStart) {
       m_mapStart = false;
-      (*m_stack.top()) = json::object();
    } else {
-      m_stack.pop();
+      popFrame();
    }
+   m_keys.resize(m_frames.back().keyBegin);
+   closeFrame(m_frames.back());
 }
 
 void JsonWriteBuffer::appendVersion(const int& version, const Context& context) throw(Exception) {
@@ -161,17 +262,7 @@ void JsonWriteBuffer::appendVersion(const int& version, const Context& context)
 
 void JsonWriteBuffer::appendBits(const char* data, long int length, const Context& context) throw(Exception) {
    std::string bits;
-   unsigned char mask = 0x80;
-   for (size_t i = 0; i < length; ++i) {
-      if ((data[i / 8] & mask) != 0)
-         bits.append("1");
-      else
-         bits.append("0");
-      if (mask == 0x01)
-         mask = 0x80;
-      else
-         mask = mask >> 1;
-   }
+   BitPacking::appendText(bits, data, length);
    append(bits, context);
 }
 
@@ -181,23 +272,32 @@ void JsonWriteBuffer::appendCollectionSize(const std::size_t& size, const Contex
 
 void JsonWriteBuffer::appendTypeId(const std::string& val, const Context& context) throw(Exception) {
    std::string field = context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>();
-   (*m_stack.top())[field] = val;
+   openObject();
+   writeKey(field);
+   writeString(val);
+   popFrame();
 }
 
 void JsonWriteBuffer::append(const bool& val, const Context& context) throw(Exception) {
-   appendNumber(val);
+   if (m_keyStart) {
+      writeMapKey(m_util.toString(val));
+   } else if (!m_skipNextFundamental) {
+      static const char trueText[] = "true";
+      static const char falseText[] = "false";
+      if (val) {
+         writeScalar(trueText, trueText + 4);
+      } else {
+         writeScalar(falseText, falseText + 5);
+      }
+   }
 }
 
 
 void JsonWriteBuffer::append(const char& val, const Context& context) throw(Exception) {
    if (m_keyStart) {
-      if (!(*m_stack.top())[m_util.toString(val)].is_null()) {
-         throw Exception("Multimaps with duplicated keys aren't supported when serializing to JSON");
-      }
-      (*m_stack.top())[m_util.toString(val)] = json();
-      m_stack.push(&(*m_stack.top())[m_util.toString(val)]);
+      writeMapKey(m_util.toString(val));
    } else if (!m_skipNextFundamental) {
-      (*m_stack.top()) = m_util.toString(val);
+      writeString(m_util.toString(val));
    }
 }
 
@@ -223,7 +323,11 @@ void JsonWriteBuffer::append(const long long& val, const Context& context) throw
 
 
 void JsonWriteBuffer::append(const unsigned char& val, const Context& context) throw(Exception) {
-   appendNumber(val);
+   if (m_keyStart) {
+      writeMapKey(m_util.toString(val));
+   } else {
+      appendNumber(static_cast<unsigned int>(val));
+   }
 }
 
 
@@ -248,31 +352,43 @@ void JsonWriteBuffer::append(const unsigned long long& val, const Context& conte
 
 
 void JsonWriteBuffer::append(const float& val, const Context& context) throw(Exception) {
-   appendNumber(val);
+   appendFloatingPoint(val);
 }
 
 
 void JsonWriteBuffer::append(const double& val, const Context& context) throw(Exception) {
-   appendNumber(val);
+   appendFloatingPoint(val);
 }
 
 
 void JsonWriteBuffer::append(const std::string& val, const Context& context) throw(Exception) {
    if (m_keyStart) {
-      if (!(*m_stack.top())[val].is_null()) {
-         throw Exception("Multimaps with duplicated keys aren't supported when serializing to JSON");
-      }
-      (*m_stack.top())[val] = json();
-      m_stack.push(&(*m_stack.top())[val]);
+      writeMapKey(val);
    } else if (!m_skipNextFundamental) {
-      (*m_stack.top()) = val;
+      writeString(val);
    }
 }
 
-std::string JsonWriteBuffer::getOutput() const {
-   if (m_indentation == 0) {
-      return m_document.dump();
-   } else {
-      return m_document.dump(m_indentation);
+std::size_t JsonWriteBuffer::position() const {
+   return m_output.size();
+}
+
+void JsonWriteBuffer::reset() {
+   AbstractWriteBuffer::reset();
+   m_output.clear();
+   m_keys.clear();
+   m_frames.clear();
+   m_frames.push_back(Frame());
+   m_collectionStart = false;
+   m_mapStart = false;
+   m_keyStart = false;
+   m_skipNextFundamental = false;
+}
+
+const std::string& JsonWriteBuffer::getOutput() {
+   while (m_frames.size() > 1) {
+      popFrame();
    }
+   closeFrame(m_frames.back());
+   return m_output;
 }
@@ -0,0 +1,570 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/buffer/numberFormat.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+#include <limits>
+#include <string>
+
+using namespace ctrl;
+using namespace ctrl::Private;
+
+// Floating point values are formatted with the Grisu2 algorithm described in
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers" by
+// Florian Loitsch. The result always reads back to the same value and is the
+// shortest such representation for nearly all inputs.
+
+namespace {
+
+   struct DiyFp {
+      DiyFp(std::uint64_t f_, int e_) : f(f_), e(e_) {}
+
+      std::uint64_t f;
+      int e;
+   };
+
+   DiyFp subtract(const DiyFp& x, const DiyFp& y) {
+      return DiyFp(x.f - y.f, x.e);
+   }
+
+   DiyFp multiply(const DiyFp& x, const DiyFp& y) {
+      const std::uint64_t mask = 0xffffffffULL;
+      std::uint64_t a = x.f >> 32;
+      std::uint64_t b = x.f & mask;
+      std::uint64_t c = y.f >> 32;
+      std::uint64_t d = y.f & mask;
+      std::uint64_t ac = a * c;
+      std::uint64_t bc = b * c;
+      std::uint64_t ad = a * d;
+      std::uint64_t bd = b * d;
+      std::uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+      return DiyFp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64);
+   }
+
+   DiyFp normalize(DiyFp x) {
+      while ((x.f >> 63) == 0) {
+         x.f <<= 1;
+         --x.e;
+      }
+      return x;
+   }
+
+   struct CachedPower {
+      std::uint64_t f;
+      int e;
+      int k;
+   };
+
+   // Normalized approximations f * 2^e of 10^k for every eighth k.
+   const CachedPower cachedPowers[] = {
+      { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+      { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+      { 0xBE5691EF416BD60CULL, -1007, -284 },
+      { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+      { 0xD3515C2831559A83ULL,  -954, -268 },
+      { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+      { 0xEA9C227723EE8BCBULL,  -901, -252 },
+      { 0xAECC49914078536DULL,  -874, -244 },
+      { 0x823C12795DB6CE57ULL,  -847, -236 },
+      { 0xC21094364DFB5637ULL,  -821, -228 },
+      { 0x9096EA6F3848984FULL,  -794, -220 },
+      { 0xD77485CB25823AC7ULL,  -768, -212 },
+      { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+      { 0xEF340A98172AACE5ULL,  -715, -196 },
+      { 0xB23867FB2A35B28EULL,  -688, -188 },
+      { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+      { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+      { 0x936B9FCEBB25C996ULL,  -608, -164 },
+      { 0xDBAC6C247D62A584ULL,  -582, -156 },
+      { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+      { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+      { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+      { 0x87625F056C7C4A8BULL,  -475, -124 },
+      { 0xC9BCFF6034C13053ULL,  -449, -116 },
+      { 0x964E858C91BA2655ULL,  -422, -108 },
+      { 0xDFF9772470297EBDULL,  -396, -100 },
+      { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+      { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+      { 0xB94470938FA89BCFULL,  -316,  -76 },
+      { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+      { 0xCDB02555653131B6ULL,  -263,  -60 },
+      { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+      { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+      { 0xAA242499697392D3ULL,  -183,  -36 },
+      { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+      { 0xBCE5086492111AEBULL,  -130,  -20 },
+      { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+      { 0xD1B71758E219652CULL,   -77,   -4 },
+      { 0x9C40000000000000ULL,   -50,    4 },
+      { 0xE8D4A51000000000ULL,   -24,   12 },
+      { 0xAD78EBC5AC620000ULL,     3,   20 },
+      { 0x813F3978F8940984ULL,    30,   28 },
+      { 0xC097CE7BC90715B3ULL,    56,   36 },
+      { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+      { 0xD5D238A4ABE98068ULL,   109,   52 },
+      { 0x9F4F2726179A2245ULL,   136,   60 },
+      { 0xED63A231D4C4FB27ULL,   162,   68 },
+      { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+      { 0x83C7088E1AAB65DBULL,   216,   84 },
+      { 0xC45D1DF942711D9AULL,   242,   92 },
+      { 0x924D692CA61BE758ULL,   269,  100 },
+      { 0xDA01EE641A708DEAULL,   295,  108 },
+      { 0xA26DA3999AEF774AULL,   322,  116 },
+      { 0xF209787BB47D6B85ULL,   348,  124 },
+      { 0xB454E4A179DD1877ULL,   375,  132 },
+      { 0x865B86925B9BC5C2ULL,   402,  140 },
+      { 0xC83553C5C8965D3DULL,   428,  148 },
+      { 0x952AB45CFA97A0B3ULL,   455,  156 },
+      { 0xDE469FBD99A05FE3ULL,   481,  164 },
+      { 0xA59BC234DB398C25ULL,   508,  172 },
+      { 0xF6C69A72A3989F5CULL,   534,  180 },
+      { 0xB7DCBF5354E9BECEULL,   561,  188 },
+      { 0x88FCF317F22241E2ULL,   588,  196 },
+      { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+      { 0x98165AF37B2153DFULL,   641,  212 },
+      { 0xE2A0B5DC971F303AULL,   667,  220 },
+      { 0xA8D9D1535CE3B396ULL,   694,  228 },
+      { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+      { 0xBB764C4CA7A44410ULL,   747,  244 },
+      { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+      { 0xD01FEF10A657842CULL,   800,  260 },
+      { 0x9B10A4E5E9913129ULL,   827,  268 },
+      { 0xE7109BFBA19C0C9DULL,   853,  276 },
+      { 0xAC2820D9623BF429ULL,   880,  284 },
+      { 0x80444B5E7AA7CF85ULL,   907,  292 },
+      { 0xBF21E44003ACDD2DULL,   933,  300 },
+      { 0x8E679C2F5E44FF8FULL,   960,  308 },
+      { 0xD433179D9C8CB841ULL,   986,  316 },
+      { 0x9E19DB92B4E31BA9ULL,  1013,  324 },
+      { 0xEB96BF6EBADF77D9ULL,  1039,  332 },
+      { 0xAF87023B9BF0EE6BULL,  1066,  340 },
+   };
+
+   const int cachedPowersMinExponent = -300;
+   const int cachedPowersStep = 8;
+
+   // Returns a power of ten that brings a value with binary exponent e in the
+   // range [2^-60, 2^-32) after multiplication.
+   const CachedPower& cachedPowerFor(int e) {
+      int f = -60 - e - 1;
+      int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+      int index = (-cachedPowersMinExponent + k + (cachedPowersStep - 1)) / cachedPowersStep;
+      return cachedPowers[index];
+   }
+
+   template <class Float_, class Bits_>
+   void computeBoundaries(Float_ value, DiyFp& minus, DiyFp& v, DiyFp& plus) {
+      const int precision = std::numeric_limits<Float_>::digits;
+      const int bias = std::numeric_limits<Float_>::max_exponent - 1 + (precision - 1);
+      const std::uint64_t hiddenBit = 1ULL << (precision - 1);
+
+      Bits_ raw;
+      std::memcpy(&raw, &value, sizeof(raw));
+      std::uint64_t bits = raw;
+      std::uint64_t exponent = bits >> (precision - 1);
+      std::uint64_t fraction = bits & (hiddenBit - 1);
+
+      DiyFp w = exponent == 0 ? DiyFp(fraction, 1 - bias)
+                              : DiyFp(fraction + hiddenBit, static_cast<int>(exponent) - bias);
+      bool lowerBoundaryIsCloser = fraction == 0 && exponent > 1;
+      DiyFp mPlus(2 * w.f + 1, w.e - 1);
+      DiyFp mMinus = lowerBoundaryIsCloser ? DiyFp(4 * w.f - 1, w.e - 2) : DiyFp(2 * w.f - 1, w.e - 1);
+
+      plus = normalize(mPlus);
+      minus = DiyFp(mMinus.f << (mMinus.e - plus.e), plus.e);
+      v = normalize(w);
+   }
+
+   int largestPow10(std::uint32_t n, std::uint32_t& pow10) {
+      int digits = 1;
+      pow10 = 1;
+      while (digits < 10 && n / 10 >= pow10) {
+         pow10 *= 10;
+         ++digits;
+      }
+      return digits;
+   }
+
+   void roundWeed(char* buffer, int length, std::uint64_t distance, std::uint64_t delta,
+                  std::uint64_t rest, std::uint64_t tenK) {
+      while ( rest < distance && delta - rest >= tenK &&
+              (rest + tenK < distance || distance - rest > rest + tenK - distance) ) {
+         --buffer[length - 1];
+         rest += tenK;
+      }
+   }
+
+   void generateDigits(char* buffer, int& length, int& exponent, const DiyFp& minus, const DiyFp& w, const DiyFp& plus) {
+      std::uint64_t delta = subtract(plus, minus).f;
+      std::uint64_t distance = subtract(plus, w).f;
+      const DiyFp one(1ULL << -plus.e, plus.e);
+
+      std::uint32_t p1 = static_cast<std::uint32_t>(plus.f >> -one.e);
+      std::uint64_t p2 = plus.f & (one.f - 1);
+
+      std::uint32_t pow10;
+      int n = largestPow10(p1, pow10);
+      length = 0;
+      while (n > 0) {
+         buffer[length++] = static_cast<char>('0' + p1 / pow10);
+         p1 %= pow10;
+         --n;
+         std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+         if (rest <= delta) {
+            exponent += n;
+            roundWeed(buffer, length, distance, delta, rest, static_cast<std::uint64_t>(pow10) << -one.e);
+            return;
+         }
+         pow10 /= 10;
+      }
+
+      int m = 0;
+      while (true) {
+         p2 *= 10;
+         buffer[length++] = static_cast<char>('0' + (p2 >> -one.e));
+         p2 &= one.f - 1;
+         ++m;
+         delta *= 10;
+         distance *= 10;
+         if (p2 <= delta) {
+            break;
+         }
+      }
+      exponent -= m;
+      roundWeed(buffer, length, distance, delta, p2, one.f);
+   }
+
+   char* appendExponent(char* out, int e) {
+      if (e < 0) {
+         *out++ = '-';
+         e = -e;
+      } else {
+         *out++ = '+';
+      }
+      if (e >= 100) {
+         *out++ = static_cast<char>('0' + e / 100);
+         e %= 100;
+      }
+      *out++ = static_cast<char>('0' + e / 10);
+      *out++ = static_cast<char>('0' + e % 10);
+      return out;
+   }
+
+   // Turns the digits d1..dk at buffer, representing d1..dk * 10^exponent, into
+   // fixed notation when the decimal point is near, scientific notation otherwise.
+   char* placeDecimalPoint(char* buffer, int k, int exponent, int maxExponent) {
+      int n = k + exponent;
+      if (k <= n && n <= maxExponent) {
+         std::memset(buffer + k, '0', n - k);
+         buffer[n] = '.';
+         buffer[n + 1] = '0';
+         return buffer + n + 2;
+      }
+      if (0 < n && n <= maxExponent) {
+         std::memmove(buffer + n + 1, buffer + n, k - n);
+         buffer[n] = '.';
+         return buffer + k + 1;
+      }
+      if (-4 < n && n <= 0) {
+         std::memmove(buffer + 2 - n, buffer, k);
+         buffer[0] = '0';
+         buffer[1] = '.';
+         std::memset(buffer + 2, '0', -n);
+         return buffer + 2 - n + k;
+      }
+      if (k == 1) {
+         buffer += 1;
+      } else {
+         std::memmove(buffer + 2, buffer + 1, k - 1);
+         buffer[1] = '.';
+         buffer += k + 1;
+      }
+      *buffer++ = 'e';
+      return appendExponent(buffer, n - 1);
+   }
+
+   template <class Float_, class Bits_>
+   char* formatFloatingPoint(char* out, Float_ val) {
+      if (val != val) {
+         std::memcpy(out, "nan", 3);
+         return out + 3;
+      }
+      if (std::signbit(val)) {
+         *out++ = '-';
+         val = -val;
+      }
+      if (val == 0) {
+         std::memcpy(out, "0.0", 3);
+         return out + 3;
+      }
+      if (val > std::numeric_limits<Float_>::max()) {
+         std::memcpy(out, "inf", 3);
+         return out + 3;
+      }
+
+      DiyFp minus(0, 0), v(0, 0), plus(0, 0);
+      computeBoundaries<Float_, Bits_>(val, minus, v, plus);
+      const CachedPower& cached = cachedPowerFor(plus.e);
+      const DiyFp c(cached.f, cached.e);
+      DiyFp w = multiply(v, c);
+      DiyFp wMinus = multiply(minus, c);
+      DiyFp wPlus = multiply(plus, c);
+
+      int length;
+      int exponent = -cached.k;
+      generateDigits(out, length, exponent, DiyFp(wMinus.f + 1, wMinus.e), w, DiyFp(wPlus.f - 1, wPlus.e));
+      return placeDecimalPoint(out, length, exponent, std::numeric_limits<Float_>::digits10);
+   }
+
+   // A decimal number split in at most 19 significant digits and a power of ten.
+   struct Decimal {
+      std::uint64_t mantissa;
+      int exponent;
+      bool negative;
+      bool truncated;
+      int special;
+   };
+
+   enum { Finite, Infinite, NotANumber };
+
+   bool matchWord(const char* p, const char* end, const char* word) {
+      std::size_t length = std::strlen(word);
+      if (static_cast<std::size_t>(end - p) < length) {
+         return false;
+      }
+      for (std::size_t i = 0; i < length; ++i) {
+         if ((p[i] | 0x20) != word[i]) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   const char* scanDecimal(const char* p, const char* end, Decimal& decimal) {
+      decimal.mantissa = 0;
+      decimal.exponent = 0;
+      decimal.negative = false;
+      decimal.truncated = false;
+      decimal.special = Finite;
+
+      if (p < end && (*p == '-' || *p == '+')) {
+         decimal.negative = *p == '-';
+         ++p;
+      }
+      if (matchWord(p, end, "infinity")) {
+         decimal.special = Infinite;
+         return p + 8;
+      } else if (matchWord(p, end, "inf")) {
+         decimal.special = Infinite;
+         return p + 3;
+      } else if (matchWord(p, end, "nan")) {
+         decimal.special = NotANumber;
+         return p + 3;
+      }
+
+      int digits = 0;
+      bool any = false;
+      while (p < end && *p >= '0' && *p <= '9') {
+         any = true;
+         if (digits < 19) {
+            decimal.mantissa = decimal.mantissa * 10 + (*p - '0');
+            digits += decimal.mantissa != 0 ? 1 : 0;
+         } else {
+            ++decimal.exponent;
+            decimal.truncated = decimal.truncated || *p != '0';
+         }
+         ++p;
+      }
+      if (p < end && *p == '.') {
+         ++p;
+         while (p < end && *p >= '0' && *p <= '9') {
+            any = true;
+            if (digits < 19) {
+               decimal.mantissa = decimal.mantissa * 10 + (*p - '0');
+               digits += decimal.mantissa != 0 ? 1 : 0;
+               --decimal.exponent;
+            } else {
+               decimal.truncated = decimal.truncated || *p != '0';
+            }
+            ++p;
+         }
+      }
+      if (!any) {
+         return 0;
+      }
+
+      if (p < end && (*p == 'e' || *p == 'E')) {
+         ++p;
+         bool negativeExponent = false;
+         if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            ++p;
+         }
+         if (p == end || *p < '0' || *p > '9') {
+            return 0;
+         }
+         int exponent = 0;
+         while (p < end && *p >= '0' && *p <= '9') {
+            if (exponent < 100000) {
+               exponent = exponent * 10 + (*p - '0');
+            }
+            ++p;
+         }
+         decimal.exponent += negativeExponent ? -exponent : exponent;
+      }
+      return p;
+   }
+
+   // Falls back to the C library for the inputs that can't be converted exactly
+   // with a single floating point operation. The text is handed over with the
+   // decimal point of the current locale.
+   template <class Float_>
+   bool parseWithLibrary(const char* begin, const char* end, Float_& val) {
+      std::string text(begin, end);
+      char decimalPoint = *std::localeconv()->decimal_point;
+      if (decimalPoint != '.') {
+         std::string::size_type pos = text.find('.');
+         if (pos != std::string::npos) {
+            text[pos] = decimalPoint;
+         }
+      }
+      char* parsedEnd;
+      if (sizeof(Float_) == sizeof(float)) {
+         val = std::strtof(text.c_str(), &parsedEnd);
+      } else {
+         val = static_cast<Float_>(std::strtod(text.c_str(), &parsedEnd));
+      }
+      return parsedEnd == text.c_str() + text.length();
+   }
+
+   template <class Float_>
+   const char* parseFloatingPoint(const char* p, const char* end, Float_& val,
+                                  std::uint64_t maxExactMantissa, int maxExactExponent) {
+      static const double powersOf10[] = {
+         1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+      Decimal decimal;
+      const char* numberEnd = scanDecimal(p, end, decimal);
+      if (numberEnd == 0) {
+         return 0;
+      }
+
+      if (decimal.special == Infinite) {
+         val = decimal.negative ? -std::numeric_limits<Float_>::infinity() : std::numeric_limits<Float_>::infinity();
+      } else if (decimal.special == NotANumber) {
+         val = std::numeric_limits<Float_>::quiet_NaN();
+      } else if (decimal.mantissa == 0 && !decimal.truncated) {
+         val = decimal.negative ? -Float_(0) : Float_(0);
+      } else if ( !decimal.truncated && decimal.mantissa <= maxExactMantissa &&
+                  decimal.exponent >= -maxExactExponent && decimal.exponent <= maxExactExponent ) {
+         Float_ mantissa = static_cast<Float_>(decimal.mantissa);
+         Float_ power = static_cast<Float_>(powersOf10[decimal.exponent < 0 ? -decimal.exponent : decimal.exponent]);
+         val = decimal.exponent < 0 ? mantissa / power : mantissa * power;
+         val = decimal.negative ? -val : val;
+      } else if (!parseWithLibrary(p, numberEnd, val)) {
+         return 0;
+      }
+      return numberEnd;
+   }
+
+} // namespace
+
+char* NumberFormat::format(char* out, unsigned long long val) {
+   char digits[20];
+   int n = 0;
+   do {
+      digits[n++] = static_cast<char>('0' + val % 10);
+      val /= 10;
+   } while (val != 0);
+   while (n > 0) {
+      *out++ = digits[--n];
+   }
+   return out;
+}
+
+char* NumberFormat::format(char* out, long long val) {
+   if (val < 0) {
+      *out++ = '-';
+      return format(out, 0ULL - static_cast<unsigned long long>(val));
+   }
+   return format(out, static_cast<unsigned long long>(val));
+}
+
+char* NumberFormat::format(char* out, double val) {
+   return formatFloatingPoint<double, std::uint64_t>(out, val);
+}
+
+char* NumberFormat::format(char* out, float val) {
+   return formatFloatingPoint<float, std::uint32_t>(out, val);
+}
+
+const char* NumberFormat::parse(const char* p, const char* end, unsigned long long& val) {
+   const unsigned long long max = std::numeric_limits<unsigned long long>::max();
+   const char* start = p;
+   unsigned long long result = 0;
+   while (p < end && *p >= '0' && *p <= '9') {
+      unsigned int digit = *p - '0';
+      if (result > max / 10 || (result == max / 10 && digit > max % 10)) {
+         return 0;
+      }
+      result = result * 10 + digit;
+      ++p;
+   }
+   if (p == start) {
+      return 0;
+   }
+   val = result;
+   return p;
+}
+
+const char* NumberFormat::parse(const char* p, const char* end, long long& val) {
+   bool negative = p < end && *p == '-';
+   unsigned long long magnitude;
+   const char* numberEnd = parse(negative ? p + 1 : p, end, magnitude);
+   if (numberEnd == 0) {
+      return 0;
+   }
+   const unsigned long long max = static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+   if (magnitude > max + (negative ? 1 : 0)) {
+      return 0;
+   }
+   val = negative ? static_cast<long long>(0ULL - magnitude) : static_cast<long long>(magnitude);
+   return numberEnd;
+}
+
+const char* NumberFormat::parse(const char* p, const char* end, double& val) {
+   return parseFloatingPoint(p, end, val, 1ULL << 53, 22);
+}
+
+const char* NumberFormat::parse(const char* p, const char* end, float& val) {
+   return parseFloatingPoint(p, end, val, 1ULL << 24, 10);
+}
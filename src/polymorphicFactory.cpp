@@ -49,3 +49,7 @@ void* PolymorphicFactory::deserialize(AbstractReadBuffer& buffer, const IdField&
                                       int version, const Context& context) const {
    return m_pimpl->deserialize(buffer, idField, className, version, context);
 }
+
+PolymorphicFactory::DeleteFunction PolymorphicFactory::getDelete() const {
+   return m_pimpl->getDelete();
+}
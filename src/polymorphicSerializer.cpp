@@ -26,14 +26,17 @@
 
 #include <ctrl/polymorphicSerializer.h>
 #include <ctrl/buffer/abstractReadBuffer.h>
+#include <ctrl/exception.h>
 #include <iostream>
 #include <algorithm>
 
 using namespace ctrl;
 using namespace ctrl::Private;
 
-PolymorphicSerializer::PolymorphicSerializer() {
-
+PolymorphicSerializer::PolymorphicSerializer()
+   : m_current(0), m_changed(false), m_frozen(false) {
+   m_snapshots.push_back(std::unique_ptr<const Snapshot>(new Snapshot()));
+   m_current.store(m_snapshots.back().get());
 }
 
 PolymorphicSerializer::~PolymorphicSerializer() {
@@ -45,24 +48,89 @@ PolymorphicSerializer& PolymorphicSerializer::instance() {
    return serializer;
 }
 
+void PolymorphicSerializer::publish() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (m_changed.load(std::memory_order_relaxed)) {
+      m_snapshots.push_back(std::unique_ptr<const Snapshot>(new Snapshot(m_pending)));
+      m_current.store(m_snapshots.back().get(), std::memory_order_release);
+      m_changed.store(false, std::memory_order_release);
+   }
+}
+
+PolymorphicSerializer::Snapshot* PolymorphicSerializer::pending(const std::string& className) {
+   if (m_frozen) {
+      if (std::find(m_rejected.begin(), m_rejected.end(), className) == m_rejected.end())
+         m_rejected.push_back(className);
+      return 0;
+   }
+   m_changed.store(true, std::memory_order_release);
+   return &m_pending;
+}
+
+void PolymorphicSerializer::freeze() {
+   publish();
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_frozen = true;
+}
+
+bool PolymorphicSerializer::isFrozen() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_frozen;
+}
+
+std::vector<std::string> PolymorphicSerializer::rejectedTypes() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_rejected;
+}
+
 bool PolymorphicSerializer::isPolymorph(const std::string& className) const {
-   return m_factories.find(className) != m_factories.end() ||
-          std::find(m_abstractBaseClasses.begin(), m_abstractBaseClasses.end(), className) != m_abstractBaseClasses.end();
+   return find([&](const Snapshot& current) {
+      return current.factories.find(className) != current.factories.end() ||
+             current.abstractBaseClasses.find(className) != current.abstractBaseClasses.end();
+   });
 }
 
 void* PolymorphicSerializer::deserialize(const std::string& className, AbstractReadBuffer& buffer, int version,
                                          const IdField& idField, const Context& context) const {
-   return m_factories.at(className).deserialize(buffer, idField, className, version, context);
+   const PolymorphicFactory* factory = 0;
+   find([&](const Snapshot& current) {
+      std::map<std::string, PolymorphicFactory>::const_iterator iter = current.factories.find(className);
+      factory = iter != current.factories.end() ? &iter->second : 0;
+      return factory != 0;
+   });
+   if (factory == 0)
+      throw Exception("Unknown polymorphic type '" + className + "'");
+   return factory->deserialize(buffer, idField, className, version, context);
+}
+
+PolymorphicFactory::DeleteFunction PolymorphicSerializer::getDelete(const std::string& className) const {
+   PolymorphicFactory::DeleteFunction deleteObject = 0;
+   find([&](const Snapshot& current) {
+      std::map<std::string, PolymorphicFactory>::const_iterator iter = current.factories.find(className);
+      deleteObject = iter != current.factories.end() ? iter->second.getDelete() : 0;
+      return deleteObject != 0;
+   });
+   if (deleteObject == 0)
+      throw Exception("Unknown polymorphic type '" + className + "'");
+   return deleteObject;
 }
 
 int PolymorphicSerializer::registerDeserialize( const std::string& className
                                               , const PolymorphicFactory& factory ) {
-   m_factories[className] = factory;
+   std::lock_guard<std::mutex> lock(m_mutex);
+   Snapshot* registry = pending(className);
+   if (registry == 0)
+      return -1;
+   registry->factories[className] = factory;
    return 0;
 }
 
 int PolymorphicSerializer::registerAbstract(const std::string& className) {
-   m_abstractBaseClasses.push_back(className);
+   std::lock_guard<std::mutex> lock(m_mutex);
+   Snapshot* registry = pending(className);
+   if (registry == 0)
+      return -1;
+   registry->abstractBaseClasses.insert(className);
    return 0;
 }
 
@@ -70,27 +138,42 @@ int PolymorphicSerializer::registerAbstract(const std::string& className) {
 int PolymorphicSerializer::registerCast( const std::string& from
                                        , const std::string& to
                                        , PolymorphicSerializer::CastFunction func) {
-   m_casts[from][to] = func;
+   std::lock_guard<std::mutex> lock(m_mutex);
+   Snapshot* registry = pending(from);
+   if (registry == 0)
+      return -1;
+   registry->casts[from][to] = func;
    return 0;
 }
 
+PolymorphicSerializer::CastFunction PolymorphicSerializer::findCast(
+                                const std::string& from, const std::string& to) const {
+   CastFunction func = 0;
+   find([&](const Snapshot& current) {
+      Snapshot::CastMap::const_iterator iter = current.casts.find(from);
+      if (iter == current.casts.end())
+         return false;
+      std::map<std::string, CastFunction>::const_iterator cast = iter->second.find(to);
+      func = cast != iter->second.end() ? cast->second : 0;
+      return func != 0;
+   });
+   return func;
+}
+
 PolymorphicSerializer::CastFunction PolymorphicSerializer::getCast(
                                 const std::string& from, const std::string& to) const {
-   return m_casts.at(from).at(to);
+   CastFunction func = findCast(from, to);
+   if (func == 0)
+      throw Exception("No cast from '" + from + "' to '" + to + "'");
+   return func;
 }
 
 bool PolymorphicSerializer::hasCast( const std::string& from
                                    , const std::string& to ) const {
-   CastMap::const_iterator iter = m_casts.find(from);
-   if (iter == m_casts.end())
-      return false;
-   return iter->second.find(to) != iter->second.end();
+   return findCast(from, to) != 0;
 }
 
 void* PolymorphicSerializer::cast(const std::string& from, const std::string& to, void* p) const {
-   if (hasCast(from, to)) {
-      return getCast(from, to)(p);
-   } else {
-      return p;
-   }
+   CastFunction func = findCast(from, to);
+   return func != 0 ? func(p) : p;
 }
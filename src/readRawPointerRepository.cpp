@@ -26,6 +26,7 @@
 
 #include <ctrl/buffer/readRawPointerRepository.h>
 #include <ctrl/idField.h>
+#include <ctrl/instrumentation.h>
 
 using namespace ctrl;
 using namespace ctrl::Private;
@@ -39,6 +40,7 @@ bool ReadRawPointerRepository::isRegistered(const IdField& i) const {
 }
 
 void* ReadRawPointerRepository::get(const IdField& i) const {
+   CTRL_INSTRUMENT_RESOLVED_POINTER();
    return m_ptrs.at(i).first;
 }
 
@@ -49,3 +51,11 @@ void ReadRawPointerRepository::add(const IdField& i, void* p, const std::string&
 std::string ReadRawPointerRepository::getTypeName(const IdField& i) const {
    return m_ptrs.at(i).second;
 }
+
+void ReadRawPointerRepository::clear() {
+   m_ptrs.clear();
+}
+
+std::size_t ReadRawPointerRepository::size() const {
+   return m_ptrs.size();
+}
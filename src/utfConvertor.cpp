@@ -0,0 +1,251 @@
+
+/*
+ * Copyright (C) 2026 by Gerrit Daniels <gerrit.daniels@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctrl/buffer/utfConvertor.h>
+#include <cstdint>
+#include <cstring>
+
+using namespace ctrl;
+using namespace ctrl::Private;
+
+namespace {
+
+   const std::size_t blockSize = 8;
+   const std::uint64_t highBits = 0x8080808080808080ULL;
+
+   template <std::size_t size_>
+   struct WideUnits;
+
+   template <>
+   struct WideUnits<2> {
+      static bool read(const wchar_t*& p, const wchar_t* end, std::uint32_t& code) {
+         code = static_cast<std::uint16_t>(*p++);
+         if (code < 0xd800 || code > 0xdfff) {
+            return true;
+         }
+         if (code > 0xdbff || p == end) {
+            return false;
+         }
+         std::uint32_t low = static_cast<std::uint16_t>(*p);
+         if (low < 0xdc00 || low > 0xdfff) {
+            return false;
+         }
+         ++p;
+         code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+         return true;
+      }
+
+      static std::size_t length(std::uint32_t code) {
+         return code < 0x10000 ? 1 : 2;
+      }
+
+      static wchar_t* write(std::uint32_t code, wchar_t* out) {
+         if (code < 0x10000) {
+            *out++ = static_cast<wchar_t>(code);
+         } else {
+            code -= 0x10000;
+            *out++ = static_cast<wchar_t>(0xd800 + (code >> 10));
+            *out++ = static_cast<wchar_t>(0xdc00 + (code & 0x3ff));
+         }
+         return out;
+      }
+   };
+
+   template <>
+   struct WideUnits<4> {
+      static bool read(const wchar_t*& p, const wchar_t* end, std::uint32_t& code) {
+         code = static_cast<std::uint32_t>(*p++);
+         return code < 0xd800 || (code > 0xdfff && code <= 0x10ffff);
+      }
+
+      static std::size_t length(std::uint32_t code) {
+         return 1;
+      }
+
+      static wchar_t* write(std::uint32_t code, wchar_t* out) {
+         *out++ = static_cast<wchar_t>(code);
+         return out;
+      }
+   };
+
+   typedef WideUnits<sizeof(wchar_t)> Wide;
+
+   std::size_t utf8Length(std::uint32_t code) {
+      return code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+   }
+
+   char* writeUtf8(std::uint32_t code, char* out) {
+      if (code < 0x80) {
+         *out++ = static_cast<char>(code);
+      } else if (code < 0x800) {
+         *out++ = static_cast<char>(0xc0 | (code >> 6));
+         *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      } else if (code < 0x10000) {
+         *out++ = static_cast<char>(0xe0 | (code >> 12));
+         *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+         *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      } else {
+         *out++ = static_cast<char>(0xf0 | (code >> 18));
+         *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+         *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+         *out++ = static_cast<char>(0x80 | (code & 0x3f));
+      }
+      return out;
+   }
+
+   bool isContinuation(unsigned char c) {
+      return (c & 0xc0) == 0x80;
+   }
+
+   // Decodes one code point and advances p past it. Rejects overlong forms,
+   // surrogates and values above U+10FFFF; on failure only the lead byte is
+   // consumed.
+   bool readUtf8(const char*& p, const char* end, std::uint32_t& code) {
+      const unsigned char* s = reinterpret_cast<const unsigned char*>(p);
+      std::size_t available = end - p;
+      unsigned char lead = s[0];
+      ++p;
+      if (lead < 0x80) {
+         code = lead;
+         return true;
+      } else if (lead >= 0xc2 && lead <= 0xdf) {
+         if (available < 2 || !isContinuation(s[1]))
+            return false;
+         code = ((lead & 0x1f) << 6) | (s[1] & 0x3f);
+         p += 1;
+         return true;
+      } else if (lead >= 0xe0 && lead <= 0xef) {
+         if (available < 3 || !isContinuation(s[1]) || !isContinuation(s[2]))
+            return false;
+         if ((lead == 0xe0 && s[1] < 0xa0) || (lead == 0xed && s[1] > 0x9f))
+            return false;
+         code = ((lead & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+         p += 2;
+         return true;
+      } else if (lead >= 0xf0 && lead <= 0xf4) {
+         if (available < 4 || !isContinuation(s[1]) || !isContinuation(s[2]) || !isContinuation(s[3]))
+            return false;
+         if ((lead == 0xf0 && s[1] < 0x90) || (lead == 0xf4 && s[1] > 0x8f))
+            return false;
+         code = ((lead & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+         p += 3;
+         return true;
+      }
+      return false;
+   }
+
+   bool isAsciiBlock(const wchar_t* p) {
+      std::uint32_t bits = 0;
+      for (std::size_t i = 0; i < blockSize; ++i)
+         bits |= static_cast<std::uint32_t>(p[i]);
+      return bits < 0x80;
+   }
+
+   bool isAsciiBlock(const char* p) {
+      std::uint64_t word;
+      std::memcpy(&word, p, blockSize);
+      return (word & highBits) == 0;
+   }
+
+} // namespace
+
+std::size_t UtfConvertor::utf8Length(const wchar_t* begin, const wchar_t* end) {
+   std::size_t length = 0;
+   const wchar_t* p = begin;
+   while (p != end) {
+      while (static_cast<std::size_t>(end - p) >= blockSize && isAsciiBlock(p)) {
+         p += blockSize;
+         length += blockSize;
+      }
+      if (p == end)
+         break;
+      std::uint32_t code;
+      if (Wide::read(p, end, code))
+         length += ::utf8Length(code);
+   }
+   return length;
+}
+
+char* UtfConvertor::toUtf8(const wchar_t* begin, const wchar_t* end, char* out) {
+   const wchar_t* p = begin;
+   while (p != end) {
+      while (static_cast<std::size_t>(end - p) >= blockSize && isAsciiBlock(p)) {
+         for (std::size_t i = 0; i < blockSize; ++i)
+            out[i] = static_cast<char>(p[i]);
+         p += blockSize;
+         out += blockSize;
+      }
+      if (p == end)
+         break;
+      std::uint32_t code;
+      if (Wide::read(p, end, code))
+         out = writeUtf8(code, out);
+   }
+   return out;
+}
+
+std::size_t UtfConvertor::wideLength(const char* begin, const char* end) {
+   std::size_t length = 0;
+   const char* p = begin;
+   while (p != end) {
+      while (static_cast<std::size_t>(end - p) >= blockSize && isAsciiBlock(p)) {
+         p += blockSize;
+         length += blockSize;
+      }
+      if (p == end)
+         break;
+      std::uint32_t code;
+      if (readUtf8(p, end, code))
+         length += Wide::length(code);
+   }
+   return length;
+}
+
+bool UtfConvertor::appendCodePoint(std::string& out, std::uint32_t code) {
+   if ((code >= 0xd800 && code <= 0xdfff) || code > 0x10ffff)
+      return false;
+   char units[4];
+   out.append(units, writeUtf8(code, units));
+   return true;
+}
+
+wchar_t* UtfConvertor::toWide(const char* begin, const char* end, wchar_t* out) {
+   const char* p = begin;
+   while (p != end) {
+      while (static_cast<std::size_t>(end - p) >= blockSize && isAsciiBlock(p)) {
+         for (std::size_t i = 0; i < blockSize; ++i)
+            out[i] = static_cast<wchar_t>(p[i]);
+         p += blockSize;
+         out += blockSize;
+      }
+      if (p == end)
+         break;
+      std::uint32_t code;
+      if (readUtf8(p, end, code))
+         out = Wide::write(code, out);
+   }
+   return out;
+}
@@ -25,6 +25,7 @@
  */
 
 #include <ctrl/buffer/writePointerRepository.h>
+#include <ctrl/instrumentation.h>
 
 using namespace ctrl::Private;
 
@@ -37,6 +38,7 @@ bool WritePointerRepository::isRegistered(void* p) const {
 }
 
 int WritePointerRepository::get(void* p) const {
+   CTRL_INSTRUMENT_RESOLVED_POINTER();
    return m_indices.at(p);
 }
 
@@ -63,3 +65,13 @@ void WritePointerRepository::clearReserved(void* p) {
    m_reserved.erase(p);
    m_indices[p] = index;
 }
+
+void WritePointerRepository::clear() {
+   m_indices.clear();
+   m_reserved.clear();
+   m_nextIndex = 1;
+}
+
+std::size_t WritePointerRepository::size() const {
+   return m_indices.size() + m_reserved.size();
+}
@@ -24,7 +24,12 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 #include <ctrl/buffer/xmlReadBuffer.h>
+#include <ctrl/buffer/utfConvertor.h>
+#include <ctrl/buffer/bitPacking.h>
 #include <ctrl/properties.h>
 
 using namespace rapidxml;
@@ -32,29 +37,171 @@ using namespace ctrl;
 using namespace ctrl::Private;
 
 XmlReadBuffer::XmlReadBuffer(const std::string& data) : m_collectionStart(false),
-		m_nextValueIsAttribute(false), m_skipNextFundamental(false) {
-   m_document.parse<0>(const_cast<char*>(data.c_str()));
-   xml_node<>* node = m_document.first_node("root");
+		m_nextValueIsAttribute(false), m_skipNextFundamental(false), m_inPlace(false),
+		m_recordErrors(false), m_failed(false), m_missingNode(node_element) {
+   // rapidxml only accepts a mutable pointer, but doesn't write through it in
+   // non destructive mode.
+   try {
+      m_document.parse<parse_non_destructive>(const_cast<char*>(data.c_str()));
+   }
+   catch (rapidxml::parse_error& e) {
+      throw ctrl::Exception(std::string("Corrupt data: ") + e.what(), e.where<char>() - data.c_str());
+   }
+   xml_node<>* node = m_document.first_node("root", 4);
+   checkNonNull(node, "root");
+   m_stack.push_back(Level(node));
+}
+
+XmlReadBuffer::XmlReadBuffer(char* data) : m_collectionStart(false),
+		m_nextValueIsAttribute(false), m_skipNextFundamental(false), m_inPlace(true),
+		m_recordErrors(false), m_failed(false), m_missingNode(node_element) {
+   try {
+      m_document.parse<0>(data);
+   }
+   catch (rapidxml::parse_error& e) {
+      throw ctrl::Exception(std::string("Corrupt data: ") + e.what(), e.where<char>() - data);
+   }
+   xml_node<>* node = m_document.first_node("root", 4);
    checkNonNull(node, "root");
-   m_stack.push(node);
+   m_stack.push_back(Level(node));
 }
 
 std::string XmlReadBuffer::unwindStack() {
    std::string context;
-   while (!m_stack.empty()) {
-      context.insert(0, m_stack.top()->name());
-      m_stack.pop();
-      if (!m_stack.empty()) {
-         context.insert(0, ".");
+   for (std::vector<Level>::const_iterator iter = m_stack.begin(); iter != m_stack.end(); ++iter) {
+      if (iter != m_stack.begin()) {
+         context.append(".");
       }
+      context.append(iter->node->name(), iter->node->name_size());
    }
    return context;
 }
 
-void XmlReadBuffer::checkNonNull(const rapidxml::xml_base<>* node, const std::string& name) {
+void XmlReadBuffer::recordErrors() {
+   m_recordErrors = true;
+}
+
+bool XmlReadBuffer::failed() const {
+   return m_failed;
+}
+
+const std::string& XmlReadBuffer::errorReason() const {
+   return m_errorReason;
+}
+
+std::size_t XmlReadBuffer::errorPosition() const {
+   return Exception::unknownPosition;
+}
+
+void XmlReadBuffer::fail(const std::string& message) throw(Exception) {
+   if (!m_recordErrors) {
+      throw ctrl::Exception(message);
+   }
+   if (!m_failed) {
+      m_failed = true;
+      m_errorReason = message;
+   }
+}
+
+xml_node<>* XmlReadBuffer::checkNonNull(xml_node<>* node, const std::string& name) {
    if (node == 0)  {
-      throw ctrl::Exception("Corrupt data: no node with name '" + name + "' found (context: " + unwindStack() + ")");
+      fail("Corrupt data: no node with name '" + name + "' found (context: " + unwindStack() + ")");
+      return &m_missingNode;
    }
+   return node;
+}
+
+xml_attribute<>* XmlReadBuffer::checkNonNull(xml_attribute<>* attr, const std::string& name) {
+   if (attr == 0)  {
+      fail("Corrupt data: no node with name '" + name + "' found (context: " + unwindStack() + ")");
+      return &m_missingAttribute;
+   }
+   return attr;
+}
+
+const std::string& XmlReadBuffer::readValue(const xml_base<>* node) {
+   const char* p = node->value();
+   const char* end = p + node->value_size();
+   if (m_inPlace) {
+      m_value.assign(p, end);
+      return m_value;
+   }
+
+   m_value.clear();
+   while (p < end) {
+      const char* amp = reinterpret_cast<const char*>(std::memchr(p, '&', end - p));
+      if (amp == 0) {
+         m_value.append(p, end);
+         break;
+      }
+      m_value.append(p, amp);
+      const char* semicolon = reinterpret_cast<const char*>(std::memchr(amp, ';', end - amp));
+      if (semicolon == 0) {
+         m_value.append(amp, end);
+         break;
+      }
+      std::string::size_type length = semicolon - amp - 1;
+      const char* entity = amp + 1;
+      if (length == 2 && std::memcmp(entity, "lt", 2) == 0) {
+         m_value += '<';
+      } else if (length == 2 && std::memcmp(entity, "gt", 2) == 0) {
+         m_value += '>';
+      } else if (length == 3 && std::memcmp(entity, "amp", 3) == 0) {
+         m_value += '&';
+      } else if (length == 4 && std::memcmp(entity, "quot", 4) == 0) {
+         m_value += '"';
+      } else if (length == 4 && std::memcmp(entity, "apos", 4) == 0) {
+         m_value += '\'';
+      } else if (length > 0 && entity[0] == '#') {
+         // strtoul skips white space and takes a sign, so the digits are
+         // checked before it runs.
+         bool hex = entity[1] == 'x';
+         const char* digits = hex ? entity + 2 : entity + 1;
+         char* numberEnd = 0;
+         unsigned long code = 0;
+         if (hex ? std::isxdigit(static_cast<unsigned char>(*digits)) : std::isdigit(static_cast<unsigned char>(*digits))) {
+            code = std::strtoul(digits, &numberEnd, hex ? 16 : 10);
+         }
+         if ( numberEnd != semicolon || code > 0x10ffff ||
+               !UtfConvertor::appendCodePoint(m_value, static_cast<std::uint32_t>(code)) ) {
+            fail("Corrupt data: invalid character reference (context: " + unwindStack() + ")");
+            m_value.clear();
+            break;
+         }
+      } else {
+         m_value.append(amp, semicolon + 1);
+      }
+      p = semicolon + 1;
+   }
+   return m_value;
+}
+
+const std::string& XmlReadBuffer::readNodeOrAttributeValue(xml_node<>* node) {
+   if (m_nextValueIsAttribute) {
+      xml_attribute<>* attr = node->first_attribute(m_attributeName.c_str(), m_attributeName.length());
+      return readValue(checkNonNull(attr, m_attributeName));
+   }
+   return readValue(node);
+}
+
+xml_node<>* XmlReadBuffer::findChild(const char* name, std::size_t length) {
+   Level& level = m_stack.back();
+   xml_node<>* node = level.cursor;
+   if (node == 0 || node->name_size() != length || std::memcmp(node->name(), name, length) != 0) {
+      node = level.node->first_node(name, length);
+   }
+   if (node != 0) {
+      level.cursor = node->next_sibling();
+   }
+   return node;
+}
+
+xml_node<>* XmlReadBuffer::findChild(const std::string& name) {
+   return findChild(name.c_str(), name.length());
+}
+
+void XmlReadBuffer::enterChild(const std::string& name) {
+   m_stack.push_back(Level(checkNonNull(findChild(name), name)));
 }
 
 void XmlReadBuffer::enterObject(const Context& context) throw(Exception) {
@@ -78,9 +225,7 @@ void XmlReadBuffer::enterMember(const Context& context, const char* suggested) t
          m_nextValueIsAttribute = true;
          m_attributeName = name;
       } else {
-         xml_node<> *node = m_stack.top()->first_node(name.c_str());
-         checkNonNull(node, name);
-         m_stack.push(node);
+         enterChild(name);
       }
    }
 }
@@ -90,7 +235,7 @@ void XmlReadBuffer::leaveMember(const Context& context) throw(Exception) {
    if (context.getOwningMember().getProperty<AsAttribute>()) {
       m_nextValueIsAttribute = false;
    } else {
-      m_stack.pop();
+      m_stack.pop_back();
    }
 }
 
@@ -111,14 +256,12 @@ void XmlReadBuffer::enterIdField(const Context& context) throw(Exception) {
       m_nextValueIsAttribute = true;
       m_attributeName = name;
    } else {
-      xml_node<> *node = m_stack.top()->first_node(name.c_str());
-      checkNonNull(node, name);
-      m_stack.push(node);
+      enterChild(name);
    }
 }
 
 bool XmlReadBuffer::isNullId(const Context& context) throw(Exception) {
-   return m_stack.top()->first_node() == 0 && m_stack.top()->first_attribute() == 0;
+   return m_stack.back().node->first_node() == 0 && m_stack.back().node->first_attribute() == 0;
 }
 
 void XmlReadBuffer::leaveIdField(const Context& context) throw(Exception) {
@@ -127,7 +270,7 @@ void XmlReadBuffer::leaveIdField(const Context& context) throw(Exception) {
           || context.getClassContext().getRootProperty<IdFieldAsAttribute>()) {
       m_nextValueIsAttribute = false;
    } else {
-      m_stack.pop();
+      m_stack.pop_back();
    }
 }
 
@@ -142,15 +285,15 @@ void XmlReadBuffer::enterMap(const Context& context) throw(Exception) {
 void XmlReadBuffer::nextCollectionElement(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
-      xml_node<> *node = m_stack.top()->first_node("item");
-      checkNonNull(node, "item");
-      m_stack.push(node);
    } else {
-      xml_node<>* next = m_stack.top()->next_sibling();
-      checkNonNull(next, "item");
-      m_stack.pop();
-      m_stack.push(next);
+      m_stack.pop_back();
+   }
+   Level& level = m_stack.back();
+   xml_node<>* node = checkNonNull(level.cursor, "item");
+   if (level.cursor != 0) {
+      level.cursor = node->next_sibling();
    }
+   m_stack.push_back(Level(node));
 }
 
 void XmlReadBuffer::enterKey(const Context& context) throw(Exception) {
@@ -158,9 +301,7 @@ void XmlReadBuffer::enterKey(const Context& context) throw(Exception) {
       m_nextValueIsAttribute = true;
       m_attributeName = "key";
    } else {
-      xml_node<> *node = m_stack.top()->first_node("key");
-      checkNonNull(node, "key");
-      m_stack.push(node);
+      enterChild("key");
    }
 }
 
@@ -168,25 +309,23 @@ void XmlReadBuffer::leaveKey(const Context& context) throw(Exception) {
    if (context.getOwningMember().getProperty<AsAttribute>()) {
       m_nextValueIsAttribute = false;
    } else {
-      m_stack.pop();
+      m_stack.pop_back();
    }
 }
 
 void XmlReadBuffer::enterValue(const Context& context) throw(Exception) {
-   xml_node<> *node = m_stack.top()->first_node("value");
-   checkNonNull(node, "value");
-   m_stack.push(node);
+   enterChild("value");
 }
 
 void XmlReadBuffer::leaveValue(const Context& context) throw(Exception) {
-   m_stack.pop();
+   m_stack.pop_back();
 }
 
 void XmlReadBuffer::leaveCollection(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
    } else {
-      m_stack.pop();
+      m_stack.pop_back();
    }
 }
 
@@ -194,42 +333,25 @@ void XmlReadBuffer::leaveMap(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
    } else {
-      m_stack.pop();
+      m_stack.pop_back();
    }
 }
 
 void XmlReadBuffer::readVersion(int& version, const Context& context) throw(Exception) {
-   xml_node<> *node = m_stack.top()->first_node("__version");
-   checkNonNull(node, "__version");
-   readNodeOrAttributeValue(node, version);
+   readNodeOrAttributeValue(checkNonNull(findChild("__version", 9), "__version"), version);
 }
 
 void XmlReadBuffer::readBits(char* data, long int length, const Context& context) throw(Exception) {
    if (!m_skipNextFundamental) {
-      std::string bits;
-      readNodeOrAttributeValue(m_stack.top(), bits);
-      if (bits.length() != length) {
-         throw ctrl::Exception("Number of bits doesn't match (context: " + unwindStack() + ")");
-      }
-
-      size_t nbChars = length / 8 + (length % 8 == 0 ? 0 : 1);
-      for (size_t i = 0; i < nbChars; ++i)
-         data[i] = 0;
-
-      unsigned char mask = 0x80;
-      for (size_t i = 0; i < length; ++i) {
-         if (bits.substr(i, 1) == "1")
-            data[i / 8] = data[i / 8] | mask;
-         if (mask == 0x01)
-            mask = 0x80;
-         else
-            mask = mask >> 1;
+      const std::string& bits = readNodeOrAttributeValue(m_stack.back().node);
+      if (!BitPacking::readText(bits.data(), bits.length(), data, length)) {
+         fail("Number of bits doesn't match (context: " + unwindStack() + ")");
       }
    }
 }
 
 void XmlReadBuffer::readCollectionSize(std::size_t& size, const Context& context) throw(Exception) {
-   xml_node<>* node = m_stack.top()->first_node();
+   xml_node<>* node = m_stack.back().node->first_node();
    size = 0;
    while (node != 0) {
       ++size;
@@ -238,70 +360,67 @@ void XmlReadBuffer::readCollectionSize(std::size_t& size, const Context& context
 }
 
 void XmlReadBuffer::readTypeId(std::string& val, const Context& context) throw(Exception) {
-   const char* field = m_document.allocate_string(context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>().c_str());
+   std::string field = context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>();
    if (context.getClassContext().getRootProperty<TypeIdFieldAsAttribute>()) {
-      xml_attribute<>* attr = m_stack.top()->first_attribute(field);
-      checkNonNull(attr, field);
-      val = attr->value();
+      xml_attribute<>* attr = m_stack.back().node->first_attribute(field.c_str(), field.length());
+      val = readValue(checkNonNull(attr, field));
    } else {
-      xml_node<> *node = m_stack.top()->first_node(field);
-      checkNonNull(node, field);
-      val = node->value();
+      val = readValue(checkNonNull(findChild(field), field));
    }
 }
 
 void XmlReadBuffer::read(bool& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue(m_stack.top(), val);
+   readNodeOrAttributeValue(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(char& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<char>(m_stack.top(), val);
+   readNodeOrAttributeValue<char>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(short& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<short>(m_stack.top(), val);
+   readNodeOrAttributeValue<short>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(int& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<int>(m_stack.top(), val);
+   readNodeOrAttributeValue<int>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(long& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<long>(m_stack.top(), val);
+   readNodeOrAttributeValue<long>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(long long& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<long long>(m_stack.top(), val);
+   readNodeOrAttributeValue<long long>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(unsigned char& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<unsigned char>(m_stack.top(), val);
+   readNodeOrAttributeValue<unsigned char>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(unsigned short& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<unsigned short>(m_stack.top(), val);
+   readNodeOrAttributeValue<unsigned short>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(unsigned int& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<unsigned int>(m_stack.top(), val);
+   readNodeOrAttributeValue<unsigned int>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(unsigned long& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<unsigned long>(m_stack.top(), val);
+   readNodeOrAttributeValue<unsigned long>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(unsigned long long& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<unsigned long long>(m_stack.top(), val);
+   readNodeOrAttributeValue<unsigned long long>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(float& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<float>(m_stack.top(), val);
+   readNodeOrAttributeValue<float>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(double& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue<double>(m_stack.top(), val);
+   readNodeOrAttributeValue<double>(m_stack.back().node, val);
 }
 
 void XmlReadBuffer::read(std::string& val, const Context& context) throw(Exception) {
-   readNodeOrAttributeValue(m_stack.top(), val);
+   readNodeOrAttributeValue(m_stack.back().node, val);
 }
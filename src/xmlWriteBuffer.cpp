@@ -24,12 +24,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <climits>
 #include <ctrl/buffer/xmlWriteBuffer.h>
-#include <ctrl/rapidxml/rapidxml_print.hpp>
+#include <ctrl/buffer/bitPacking.h>
 #include <ctrl/properties.h>
 
-using namespace rapidxml;
 using namespace ctrl;
 using namespace ctrl::Private;
 
@@ -37,30 +35,121 @@ XmlWriteBuffer::XmlWriteBuffer(bool prettyPrint) : m_collectionStart(false),
          m_nextValueIsAttribute(false),
          m_skipNextFundamental(false),
          m_prettyPrint(prettyPrint) {
-   xml_node<> *node = m_document.allocate_node(node_element, "root");
-   m_document.append_node(node);
-   m_stack.push(node);
+   openElement("root");
 }
 
 std::string XmlWriteBuffer::unwindStack() {
    std::string context;
-   while (!m_stack.empty()) {
-      context.insert(0, m_stack.top()->name());
-      m_stack.pop();
-      if (!m_stack.empty()) {
-         context.insert(0, ".");
+   for (std::vector<Element>::const_iterator iter = m_elements.begin(); iter != m_elements.end(); ++iter) {
+      if (iter != m_elements.begin()) {
+         context.append(".");
       }
+      context.append(m_names, iter->nameBegin, iter->nameLength);
    }
    return context;
 }
 
+void XmlWriteBuffer::writeIndent(std::size_t depth) {
+   if (m_prettyPrint) {
+      m_output.append(depth, '\t');
+   }
+}
+
+void XmlWriteBuffer::closeStartTag(bool forChild) {
+   Element& element = m_elements.back();
+   if (element.startTagOpen) {
+      m_output += '>';
+      element.startTagOpen = false;
+      if (forChild && m_prettyPrint) {
+         m_output += '\n';
+      }
+   }
+   element.hasChildren = element.hasChildren || forChild;
+}
+
+void XmlWriteBuffer::openElement(const std::string& name) {
+   if (!m_elements.empty()) {
+      closeStartTag(true);
+   }
+   writeIndent(m_elements.size());
+   m_output += '<';
+   m_output += name;
+   m_elements.push_back(Element(m_names.length(), name.length(), m_output.length()));
+   m_names += name;
+}
+
+void XmlWriteBuffer::closeElement() {
+   const Element& element = m_elements.back();
+   if (element.startTagOpen) {
+      m_output.append("/>");
+   } else {
+      if (element.hasChildren) {
+         writeIndent(m_elements.size() - 1);
+      }
+      m_output.append("</");
+      m_output.append(m_names, element.nameBegin, element.nameLength);
+      m_output += '>';
+   }
+   if (m_prettyPrint) {
+      // The document ends with an empty line, as it did when printed by rapidxml.
+      m_output.append(m_elements.size() == 1 ? 2 : 1, '\n');
+   }
+   m_names.resize(element.nameBegin);
+   m_elements.pop_back();
+}
+
+void XmlWriteBuffer::appendEscaped(std::string& out, const std::string& val) {
+   std::size_t begin = 0;
+   for (std::size_t i = 0; i < val.length(); ++i) {
+      const char* entity;
+      switch (val[i]) {
+      case '<':  entity = "&lt;";   break;
+      case '>':  entity = "&gt;";   break;
+      case '\'': entity = "&apos;"; break;
+      case '"':  entity = "&quot;"; break;
+      case '&':  entity = "&amp;";  break;
+      default:   continue;
+      }
+      out.append(val, begin, i - begin);
+      out.append(entity);
+      begin = i + 1;
+   }
+   out.append(val, begin, std::string::npos);
+}
+
+void XmlWriteBuffer::writeAttribute(const std::string& name, const std::string& val) {
+   Element& element = m_elements.back();
+   if (element.startTagOpen) {
+      m_output += ' ';
+      m_output += name;
+      m_output.append("=\"");
+      appendEscaped(m_output, val);
+      m_output += '"';
+      element.tagEnd = m_output.length();
+   } else {
+      m_escaped.assign(" ");
+      m_escaped += name;
+      m_escaped.append("=\"");
+      appendEscaped(m_escaped, val);
+      m_escaped += '"';
+      m_output.insert(element.tagEnd, m_escaped);
+      element.tagEnd += m_escaped.length();
+   }
+}
+
+void XmlWriteBuffer::writeText(const std::string& val) {
+   if (!val.empty()) {
+      closeStartTag(false);
+      appendEscaped(m_output, val);
+   }
+}
 
 void XmlWriteBuffer::enterObject(const Context& context) throw(Exception) {
 
 }
 
 void XmlWriteBuffer::enterMember(const Context& context, const char* suggested) throw(Exception) {
-   const char* name = m_document.allocate_string(m_util.preferedMemberName(context.getOwningMember(), suggested).c_str());
+   std::string name = m_util.preferedMemberName(context.getOwningMember(), suggested);
 
    if ( context.getOwningMember().getProperty<AsAttribute>() && !context.getOwningMember().isFundamental() &&
          !(context.getOwningMember().isMap() && context.getOwningMember().isMapKeyFundamental()) ) {
@@ -76,12 +165,7 @@ void XmlWriteBuffer::enterMember(const Context& context, const char* suggested)
          m_nextValueIsAttribute = true;
          m_attributeName = name;
       } else {
-         xml_node<> *node = m_stack.empty() ? 0 : m_stack.top()->first_node(name);
-         if (node == 0) {
-            node = m_document.allocate_node(node_element, name);
-            m_stack.top()->append_node(node);
-         }
-         m_stack.push(node);
+         openElement(name);
       }
    }
 }
@@ -93,7 +177,7 @@ void XmlWriteBuffer::leaveMember(const Context& context) throw(Exception) {
       if (context.getOwningMember().getProperty<AsAttribute>()) {
          m_nextValueIsAttribute = false;
       } else {
-         m_stack.pop();
+         closeElement();
       }
    }
 }
@@ -112,11 +196,9 @@ void XmlWriteBuffer::enterIdField(const Context& context) throw(Exception) {
    }
    if (idFieldContext.getProperty<AsAttribute>() || context.getClassContext().getRootProperty<IdFieldAsAttribute>()) {
       m_nextValueIsAttribute = true;
-      m_attributeName = m_document.allocate_string(name.c_str());
+      m_attributeName = name;
    } else {
-      xml_node<>* node = m_document.allocate_node(node_element, m_document.allocate_string(name.c_str()));
-      m_stack.top()->append_node(node);
-      m_stack.push(node);
+      openElement(name);
    }
 }
 
@@ -133,7 +215,7 @@ void XmlWriteBuffer::leaveIdField(const Context& context) throw(Exception) {
           || context.getClassContext().getRootProperty<IdFieldAsAttribute>()) {
       m_nextValueIsAttribute = false;
    } else {
-      m_stack.pop();
+      closeElement();
    }
 }
 
@@ -149,11 +231,9 @@ void XmlWriteBuffer::nextCollectionElement(const Context& context) throw(Excepti
    if (m_collectionStart) {
       m_collectionStart = false;
    } else {
-      m_stack.pop();
+      closeElement();
    }
-   xml_node<> *node = m_document.allocate_node(node_element, "item");
-   m_stack.top()->append_node(node);
-   m_stack.push(node);
+   openElement("item");
 }
 
 void XmlWriteBuffer::enterKey(const Context& context) throw(Exception) {
@@ -161,34 +241,30 @@ void XmlWriteBuffer::enterKey(const Context& context) throw(Exception) {
       m_nextValueIsAttribute = true;
       m_attributeName = "key";
    } else {
-      xml_node<> *node = m_document.allocate_node(node_element, "key");
-      m_stack.top()->append_node(node);
-      m_stack.push(node);
+      openElement("key");
    }
 }
 void XmlWriteBuffer::leaveKey(const Context& context) throw(Exception) {
    if (context.getOwningMember().getProperty<AsAttribute>()) {
       m_nextValueIsAttribute = false;
    } else {
-      m_stack.pop();
+      closeElement();
    }
 }
 
 void XmlWriteBuffer::enterValue(const Context& context) throw(Exception) {
-   xml_node<> *node = m_document.allocate_node(node_element, "value");
-   m_stack.top()->append_node(node);
-   m_stack.push(node);
+   openElement("value");
 }
 
 void XmlWriteBuffer::leaveValue(const Context& context) throw(Exception) {
-   m_stack.pop();
+   closeElement();
 }
 
 void XmlWriteBuffer::leaveCollection(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
    } else {
-      m_stack.pop();
+      closeElement();
    }
 }
 
@@ -196,29 +272,19 @@ void XmlWriteBuffer::leaveMap(const Context& context) throw(Exception) {
    if (m_collectionStart) {
       m_collectionStart = false;
    } else {
-      m_stack.pop();
+      closeElement();
    }
 }
 
 void XmlWriteBuffer::appendVersion(const int& version, const Context& context) throw(Exception) {
-   xml_node<> *node = m_document.allocate_node(node_element, "__version");
-   m_stack.top()->append_node(node);
-   setNodeOrAttributeValue(node, version);
+   openElement("__version");
+   appendValue(version);
+   closeElement();
 }
 
 void XmlWriteBuffer::appendBits(const char* data, long int length, const Context& context) throw(Exception) {
    std::string bits;
-   unsigned char mask = 0x80;
-   for (size_t i = 0; i < length; ++i) {
-      if ((data[i / 8] & mask) != 0)
-         bits.append("1");
-      else
-         bits.append("0");
-      if (mask == 0x01)
-         mask = 0x80;
-      else
-         mask = mask >> 1;
-   }
+   BitPacking::appendText(bits, data, length);
    append(bits, context);
 }
 
@@ -227,87 +293,103 @@ void XmlWriteBuffer::appendCollectionSize(const std::size_t& size, const Context
 }
 
 void XmlWriteBuffer::appendTypeId(const std::string& val, const Context& context) throw(Exception) {
-   const char* field = m_document.allocate_string(context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>().c_str());
+   const std::string& field = context.getClassContext().getRootProperty<ctrl::TypeIdFieldName>();
    if (context.getClassContext().getRootProperty<TypeIdFieldAsAttribute>()) {
-      xml_attribute<>* attr = m_document.allocate_attribute(field, m_document.allocate_string(val.c_str()));
-      m_stack.top()->append_attribute(attr);
+      writeAttribute(field, val);
    } else {
-      xml_node<> *node = m_document.allocate_node(node_element, field, m_document.allocate_string(val.c_str()));
-      m_stack.top()->append_node(node);
+      openElement(field);
+      writeText(val);
+      closeElement();
    }
 }
 
 void XmlWriteBuffer::append(const bool& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val ? "true" : "false");
+   appendValue(std::string(val ? "true" : "false"));
 }
 
 
 void XmlWriteBuffer::append(const char& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const short& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const int& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const long& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const long long& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const unsigned char& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const unsigned short& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const unsigned int& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const unsigned long& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const unsigned long long& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const float& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const double& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
 }
 
 
 void XmlWriteBuffer::append(const std::string& val, const Context& context) throw(Exception) {
-   setNodeOrAttributeValue(m_stack.top(), val);
+   appendValue(val);
+}
+
+std::size_t XmlWriteBuffer::position() const {
+   return m_output.size();
 }
 
-std::string XmlWriteBuffer::getOutput() const {
-   std::string result;
-   print(std::back_inserter(result), m_document, m_prettyPrint ? 0 : rapidxml::print_no_indenting);
-   return result;
+void XmlWriteBuffer::reset() {
+   AbstractWriteBuffer::reset();
+   m_output.clear();
+   m_names.clear();
+   m_elements.clear();
+   m_collectionStart = false;
+   m_nextValueIsAttribute = false;
+   m_skipNextFundamental = false;
+   openElement("root");
+}
+
+const std::string& XmlWriteBuffer::getOutput() {
+   while (!m_elements.empty()) {
+      closeElement();
+   }
+   return m_output;
 }
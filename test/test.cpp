@@ -24,9 +24,11 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <thread>
 #include <ctrl/ctrl.h>
 
 void writeBytes(const char* bytes, const long& length) {
@@ -226,6 +228,28 @@ bool testWString() {
    return testSerialization(obj);
 }
 
+bool testWStringTranscoding() {
+   std::cout << "testWStringTranscoding" << std::endl;
+   std::cout << "----------------------" << std::endl;
+   WStringContainer obj(L"plain ascii text, é€\U0001F600 and more ascii");
+
+   std::string json = ctrl::toJson(obj);
+   std::cout << json << std::endl;
+   if (json != "{\"m_str\":\"plain ascii text, \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 and more ascii\"}") {
+      std::cout << "Incorrect UTF-8: ";
+      return false;
+   }
+
+   WStringContainer expected(L"ok é ok");
+   WStringContainer* newObj = ctrl::fromJson<WStringContainer>("{\"m_str\": \"ok \xff\xc3\xa9\xed\xa0\x80 ok\"}");
+   if (!testAndDelete(newObj, expected, 0)) {
+      std::cout << "Invalid UTF-8 not skipped: ";
+      return false;
+   }
+
+   return testSerialization(obj);
+}
+
 //******************************************************************************
 
 class SimplePair {
@@ -337,6 +361,54 @@ bool testBitset() {
    return testSerialization(obj);
 }
 
+class LargeBitsetContainer {
+public:
+   void set(size_t pos) {
+      m_bits.set(pos);
+   }
+
+   bool operator==(const LargeBitsetContainer& that) {
+      return m_bits == that.m_bits;
+   }
+
+   CTRL_BEGIN_MEMBERS(LargeBitsetContainer)
+   CTRL_MEMBER(private, std::bitset<1001>, m_bits)
+   CTRL_END_MEMBERS()
+};
+
+bool testLargeBitset() {
+   std::cout << "testLargeBitset" << std::endl;
+   std::cout << "---------------" << std::endl;
+   LargeBitsetContainer obj;
+   for (size_t i = 0; i < 1001; i += 3) {
+      obj.set(i);
+   }
+   obj.set(1000);
+
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   bool correct = length == 136 && (unsigned char)bytes[8] == 0x92 && (unsigned char)bytes[133] == 0x80;
+   delete[] bytes;
+   if (!correct) {
+      std::cout << "Incorrect packing: ";
+      return false;
+   }
+
+   BitsetContainer expected;
+   expected.set(0);
+   expected.set(1);
+   expected.set(2);
+   expected.set(4);
+   expected.set(8);
+   BitsetContainer* newObj = ctrl::fromJson<BitsetContainer>("{\"m_bits\": \"1110100010\"}");
+   if (!testAndDelete(newObj, expected, 0)) {
+      std::cout << "Bit string not accepted: ";
+      return false;
+   }
+
+   return testSerialization(obj);
+}
+
 //******************************************************************************
 
 class SimpleClassDeque {
@@ -524,6 +596,35 @@ bool testPriorityQueue() {
    return testSerialization(obj);
 }
 
+bool testPriorityQueueHeapOrder() {
+   std::cout << "testPriorityQueueHeapOrder" << std::endl;
+   std::cout << "--------------------------" << std::endl;
+
+   SimpleClassPriorityQueue obj;
+   for (int i = 0; i < 20; ++i) {
+      obj.add(SimpleClass((i * 7) % 20, "Element"));
+   }
+
+   std::string xml = "<root><__version>1</__version><elements>"
+                     "<item><count>3</count><name>C</name></item>"
+                     "<item><count>1</count><name>A</name></item>"
+                     "<item><count>11</count><name>K</name></item>"
+                     "<item><count>2</count><name>B</name></item>"
+                     "</elements></root>";
+   SimpleClassPriorityQueue expected;
+   expected.add(SimpleClass(1, "A"));
+   expected.add(SimpleClass(2, "B"));
+   expected.add(SimpleClass(3, "C"));
+   expected.add(SimpleClass(11, "K"));
+   SimpleClassPriorityQueue* newObj = ctrl::fromXml<SimpleClassPriorityQueue>(xml);
+   if (!testAndDelete(newObj, expected, 0)) {
+      std::cout << "Heap not rebuilt: ";
+      return false;
+   }
+
+   return testSerialization(obj);
+}
+
 //******************************************************************************
 
 class SimpleClassSet {
@@ -650,6 +751,466 @@ bool testVector() {
    return testSerialization(obj);
 }
 
+class ParallelVector {
+public:
+   CTRL_BEGIN_MEMBERS(ParallelVector)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, elements)
+      CTRL_PARALLEL(4)
+   CTRL_MEMBER(public, std::vector<int>, numbers)
+      CTRL_PARALLEL(0)
+   CTRL_END_MEMBERS()
+};
+
+class SequentialVector {
+public:
+   CTRL_BEGIN_MEMBERS(SequentialVector)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, elements)
+   CTRL_MEMBER(public, std::vector<int>, numbers)
+   CTRL_END_MEMBERS()
+};
+
+bool testParallelVector() {
+   std::cout << "testParallelVector" << std::endl;
+   std::cout << "------------------" << std::endl;
+   ParallelVector parallel;
+   SequentialVector sequential;
+   for (int i = 0; i < 20000; ++i) {
+      std::string name(i % 13, 'a' + i % 26);
+      parallel.elements.push_back(SimpleClass(i, name));
+      sequential.elements.push_back(SimpleClass(i, name));
+      parallel.numbers.push_back(i * 7);
+      sequential.numbers.push_back(i * 7);
+   }
+
+   long parallelLength, sequentialLength;
+   char* parallelBytes = ctrl::toBinary(parallel, parallelLength);
+   char* sequentialBytes = ctrl::toBinary(sequential, sequentialLength);
+   bool equal = parallelLength == sequentialLength &&
+         std::equal(parallelBytes, parallelBytes + parallelLength, sequentialBytes);
+   delete[] sequentialBytes;
+   if (!equal) {
+      delete[] parallelBytes;
+      std::cout << "Incorrect binary: ";
+      return false;
+   }
+
+   SequentialVector* newObj = ctrl::fromBinary<SequentialVector>(parallelBytes, parallelLength);
+   delete[] parallelBytes;
+   equal = newObj->elements == sequential.elements && newObj->numbers == sequential.numbers;
+   delete newObj;
+   return equal;
+}
+
+typedef std::map< std::string, std::pair< int, std::weak_ptr<SimpleClass> > > PointerLinks;
+
+class PointerHolder {
+public:
+   CTRL_BEGIN_MEMBERS(PointerHolder)
+   CTRL_MEMBER(public, PointerLinks, links)
+   CTRL_END_MEMBERS()
+};
+
+class PointerHolderChild : public PointerHolder {
+public:
+   CTRL_BEGIN_MEMBERS(PointerHolderChild)
+   CTRL_BASE_CLASS(PointerHolder)
+   CTRL_MEMBER(public, int, number)
+   CTRL_END_MEMBERS()
+};
+
+bool testParallelPointers() {
+   std::cout << "testParallelPointers" << std::endl;
+   std::cout << "--------------------" << std::endl;
+   if ( !ctrl::Private::HoldsPointers< std::vector< boost::shared_ptr<SimpleClass> > >::value
+        || !ctrl::Private::HoldsPointers< std::deque< ctrl::Cached<PointerHolder> > >::value
+        || !ctrl::Private::HoldsPointers< std::array<PointerHolderChild, 2> >::value
+        || !ctrl::Private::HoldsPointers< std::vector<SimpleClass*> >::value ) {
+      std::cout << "Pointers not found: ";
+      return false;
+   }
+   if ( ctrl::Private::HoldsPointers< std::vector<SimpleClass> >::value
+        || ctrl::Private::HoldsPointers< std::vector< std::complex<double> > >::value
+        || ctrl::Private::HoldsPointers<SequentialVector>::value ) {
+      std::cout << "Pointers found in plain values: ";
+      return false;
+   }
+   return true;
+}
+
+class IndexedCollections {
+public:
+   bool operator==(const IndexedCollections& that) const {
+      return elements == that.elements && numbers == that.numbers && flags == that.flags;
+   }
+
+   CTRL_BEGIN_MEMBERS(IndexedCollections)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, elements)
+      CTRL_PARALLEL(4)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_MEMBER(public, std::deque<int>, numbers)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_MEMBER(public, std::vector<bool>, flags)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_END_MEMBERS()
+};
+
+bool testChunkIndex() {
+   std::cout << "testChunkIndex" << std::endl;
+   std::cout << "--------------" << std::endl;
+   IndexedCollections obj;
+   for (int i = 0; i < 20000; ++i) {
+      obj.elements.push_back(SimpleClass(i, std::string(i % 13, 'a' + i % 26)));
+      obj.numbers.push_back(i * 7);
+      obj.flags.push_back(i % 3 == 0);
+   }
+
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   IndexedCollections* newObj = ctrl::fromBinary<IndexedCollections>(bytes, length);
+   if (!testAndDelete(newObj, obj, 0)) {
+      delete[] bytes;
+      std::cout << "Incorrect binary: ";
+      return false;
+   }
+
+   // The number of chunks of the first collection follows the version and its size.
+   bytes[16] = 100;
+   try {
+      newObj = ctrl::fromBinary<IndexedCollections>(bytes, length);
+      delete newObj;
+      delete[] bytes;
+      std::cout << "Corrupt chunk index accepted: ";
+      return false;
+   }
+   catch (ctrl::Exception&) { }
+   delete[] bytes;
+
+   // Moving all elements to the first chunk keeps the counts adding up to the
+   // size, but they no longer fit in its length.
+   bytes = ctrl::toBinary(obj, length);
+   std::size_t nbChunks;
+   std::memcpy(&nbChunks, bytes + 16, sizeof(std::size_t));
+   for (std::size_t i = 0; i < nbChunks; ++i) {
+      std::size_t count = i == 0 ? obj.elements.size() : 0;
+      std::memcpy(bytes + 24 + 16 * i, &count, sizeof(std::size_t));
+   }
+   ctrl::ReadResult<IndexedCollections> result = ctrl::tryFromBinary<IndexedCollections>(bytes, length);
+   delete[] bytes;
+   if (nbChunks < 2 || result || result.position != 40) {
+      std::cout << "Chunk counts not checked against their length: ";
+      return false;
+   }
+
+   // The strings of the elements add up to more than the allowance, though the
+   // strings of any one chunk don't.
+   ctrl::Limits limits;
+   limits.maxAllocation = obj.elements.size() * (sizeof(SimpleClass) + sizeof(int) + sizeof(bool)) + 60000;
+   bytes = ctrl::toBinary(obj, length);
+   result = ctrl::tryFromBinary<IndexedCollections>(bytes, length, limits);
+   limits.maxAllocation += 100000;
+   ctrl::ReadResult<IndexedCollections> allowed = ctrl::tryFromBinary<IndexedCollections>(bytes, length, limits);
+   delete[] bytes;
+   if (result || !allowed) {
+      std::cout << "Allocations of the chunks not added up: ";
+      return false;
+   }
+
+   newObj = ctrl::fromJson<IndexedCollections>(ctrl::toJson(obj));
+   return testAndDelete(newObj, obj, 0);
+}
+
+class IndexedInner {
+public:
+   bool operator==(const IndexedInner& that) const {
+      return data == that.data && cached.get() == that.cached.get();
+   }
+
+   CTRL_BEGIN_MEMBERS(IndexedInner)
+   CTRL_MEMBER(public, std::vector<char>, data)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_MEMBER(public, ctrl::Cached<std::vector<char>>, cached)
+      CTRL_PARALLEL(2)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_END_MEMBERS()
+};
+
+class NestedParallel {
+public:
+   CTRL_BEGIN_MEMBERS(NestedParallel)
+   CTRL_MEMBER(public, std::vector<IndexedInner>, items)
+      CTRL_PARALLEL(4)
+   CTRL_END_MEMBERS()
+};
+
+class NestedIndexed {
+public:
+   CTRL_BEGIN_MEMBERS(NestedIndexed)
+   CTRL_MEMBER(public, std::vector<IndexedInner>, items)
+      CTRL_PARALLEL(4)
+      CTRL_WITH_CHUNK_INDEX()
+   CTRL_END_MEMBERS()
+};
+
+class NestedSequential {
+public:
+   CTRL_BEGIN_MEMBERS(NestedSequential)
+   CTRL_MEMBER(public, std::vector<IndexedInner>, items)
+   CTRL_END_MEMBERS()
+};
+
+bool testNestedChunkIndex() {
+   std::cout << "testNestedChunkIndex" << std::endl;
+   std::cout << "--------------------" << std::endl;
+   NestedParallel parallel;
+   parallel.items.resize(10000);
+   for (std::size_t i = 0; i < parallel.items.size(); i += 2500) {
+      parallel.items[i].data.assign(9000, static_cast<char>('a' + i % 26));
+      parallel.items[i + 1].cached = std::vector<char>(9000, static_cast<char>('A' + i % 26));
+   }
+   NestedSequential sequential;
+   sequential.items = parallel.items;
+
+   long parallelLength, sequentialLength;
+   char* parallelBytes = ctrl::toBinary(parallel, parallelLength);
+   char* sequentialBytes = ctrl::toBinary(sequential, sequentialLength);
+   bool equal = parallelLength == sequentialLength &&
+         std::equal(parallelBytes, parallelBytes + parallelLength, sequentialBytes);
+   if (equal) {
+      // The second time the cached members splice in the encodings made
+      // inside the parts.
+      delete[] parallelBytes;
+      parallelBytes = ctrl::toBinary(parallel, parallelLength);
+      equal = parallelLength == sequentialLength &&
+            std::equal(parallelBytes, parallelBytes + parallelLength, sequentialBytes);
+   }
+   delete[] sequentialBytes;
+   if (!equal) {
+      delete[] parallelBytes;
+      std::cout << "Incorrect binary: ";
+      return false;
+   }
+   NestedParallel* newObj = ctrl::fromBinary<NestedParallel>(parallelBytes, parallelLength);
+   delete[] parallelBytes;
+   equal = newObj->items == parallel.items;
+   delete newObj;
+   if (!equal) {
+      std::cout << "Incorrect parallel round trip: ";
+      return false;
+   }
+
+   NestedIndexed indexed;
+   indexed.items = parallel.items;
+   long length;
+   char* bytes = ctrl::toBinary(indexed, length);
+   NestedIndexed* newIndexed = ctrl::fromBinary<NestedIndexed>(bytes, length);
+   delete[] bytes;
+   equal = newIndexed->items == parallel.items;
+   delete newIndexed;
+   if (!equal) {
+      std::cout << "Incorrect indexed round trip: ";
+      return false;
+   }
+   return true;
+}
+
+class ReusableMessage {
+public:
+   typedef std::map<int, std::string> MapType;
+
+   bool operator==(const ReusableMessage& that) const {
+      return m_items == that.m_items && m_list == that.m_list && m_map == that.m_map && m_flags == that.m_flags;
+   }
+
+   CTRL_BEGIN_MEMBERS(ReusableMessage)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, m_items)
+   CTRL_MEMBER(public, std::list<int>, m_list)
+   CTRL_MEMBER(public, MapType, m_map)
+   CTRL_MEMBER(public, std::vector<bool>, m_flags)
+   CTRL_MEMBER(public, boost::shared_ptr<SimpleClass>, m_shared)
+   CTRL_MEMBER(public, std::unique_ptr<SimpleClass>, m_unique)
+   CTRL_MEMBER(public, SimpleClass*, m_raw)
+   CTRL_END_MEMBERS()
+};
+
+bool testDeserializeInto() {
+   std::cout << "testDeserializeInto" << std::endl;
+   std::cout << "-------------------" << std::endl;
+
+   ReusableMessage expected;
+   expected.m_items.push_back(SimpleClass(5, "Gerrit"));
+   expected.m_items.push_back(SimpleClass(9, "Alex"));
+   expected.m_list.push_back(3);
+   expected.m_map[1] = "one";
+   expected.m_flags.push_back(true);
+   expected.m_raw = 0;
+
+   ReusableMessage obj;
+   for (int i = 0; i < 4; ++i) {
+      obj.m_items.push_back(SimpleClass(i, "A longer name that doesn't fit in a small string"));
+      obj.m_list.push_back(i);
+      obj.m_map[i + 10] = "other";
+      obj.m_flags.push_back(false);
+   }
+   SimpleClass target(3, "Target");
+   obj.m_shared.reset(new SimpleClass(1, "Shared"));
+   obj.m_unique.reset(new SimpleClass(2, "Unique"));
+   obj.m_raw = &target;
+   const SimpleClass* items = obj.m_items.data();
+
+   long length;
+   char* bytes = ctrl::toBinary(expected, length);
+   ctrl::fromBinaryInto(obj, bytes, length);
+   delete[] bytes;
+   if (!(obj == expected) || obj.m_items.data() != items) {
+      std::cout << "Binary not deserialized in place: ";
+      return false;
+   }
+   if (obj.m_shared || obj.m_unique || obj.m_raw != 0) {
+      std::cout << "Binary null pointers not read: ";
+      return false;
+   }
+
+   obj.m_items.push_back(SimpleClass(7, "Kermit"));
+   ctrl::fromXmlInto(obj, ctrl::toXml(expected));
+   if (!(obj == expected) || obj.m_items.data() != items) {
+      std::cout << "XML not deserialized in place: ";
+      return false;
+   }
+
+   obj.m_list.clear();
+   obj.m_shared.reset(new SimpleClass(1, "Shared"));
+   obj.m_unique.reset(new SimpleClass(2, "Unique"));
+   obj.m_raw = &target;
+   ctrl::fromJsonInto(obj, ctrl::toJson(expected));
+   if (!(obj == expected) || obj.m_items.data() != items) {
+      std::cout << "JSON not deserialized in place: ";
+      return false;
+   }
+   if (obj.m_shared || obj.m_unique || obj.m_raw != 0) {
+      std::cout << "JSON null pointers not read: ";
+      return false;
+   }
+   return true;
+}
+
+//******************************************************************************
+
+class ArenaMessage {
+public:
+   typedef std::vector<int, ctrl::ArenaAllocator<int>> Values;
+   typedef std::map<int, ctrl::ArenaString, std::less<int>, ctrl::ArenaAllocator<std::pair<const int, ctrl::ArenaString>>> Names;
+
+   bool operator==(const ArenaMessage& that) const {
+      return m_title == that.m_title && m_values == that.m_values && m_names == that.m_names;
+   }
+
+   CTRL_BEGIN_MEMBERS(ArenaMessage)
+   CTRL_MEMBER(public, ctrl::ArenaString, m_title)
+   CTRL_MEMBER(public, Values, m_values)
+   CTRL_MEMBER(public, Names, m_names)
+   CTRL_END_MEMBERS()
+};
+
+bool testArena() {
+   std::cout << "testArena" << std::endl;
+   std::cout << "---------" << std::endl;
+
+   ArenaMessage obj;
+   obj.m_title = "A title that is too long for the small string buffer";
+   for (int i = 0; i < 100; ++i) {
+      obj.m_values.push_back(i);
+   }
+   obj.m_names[1] = "one";
+   obj.m_names[2] = "two";
+
+   ctrl::Arena arena(1024);
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   ArenaMessage* newObj = ctrl::fromBinary<ArenaMessage>(bytes, length, arena);
+   delete[] bytes;
+   if (!(*newObj == obj) || newObj->m_values.get_allocator().arena() != &arena || arena.allocated() < 400) {
+      std::cout << "Not allocated from arena: ";
+      return false;
+   }
+
+   arena.reset();
+   newObj = ctrl::fromJson<ArenaMessage>(ctrl::toJson(obj), arena);
+   if (!(*newObj == obj) || newObj->m_names.get_allocator().arena() != &arena) {
+      std::cout << "Not allocated from arena: ";
+      return false;
+   }
+
+   arena.reset();
+   newObj = ctrl::fromXml<ArenaMessage>(ctrl::toXml(obj), arena);
+   return *newObj == obj && obj.m_values.get_allocator().arena() == 0;
+}
+
+class ArenaTracked {
+public:
+   ~ArenaTracked() {
+      ++destroyed;
+   }
+
+   static int destroyed;
+
+   CTRL_BEGIN_MEMBERS(ArenaTracked)
+   CTRL_MEMBER(public, std::string, m_name)
+   CTRL_END_MEMBERS()
+};
+
+int ArenaTracked::destroyed = 0;
+
+class ArenaTrackedRoot {
+   CTRL_BEGIN_MEMBERS(ArenaTrackedRoot)
+   CTRL_MEMBER(public, std::vector<ArenaTracked>, m_items)
+   CTRL_MEMBER(public, ArenaTracked*, m_target)
+   CTRL_END_MEMBERS()
+};
+
+bool testArenaDestructors() {
+   std::cout << "testArenaDestructors" << std::endl;
+   std::cout << "--------------------" << std::endl;
+
+   ArenaTracked target;
+   target.m_name = "A name that is too long for the small string buffer";
+   ArenaTrackedRoot obj;
+   obj.m_items.resize(2);
+   obj.m_target = &target;
+
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   std::vector<char> padded(bytes, bytes + length);
+   padded.resize(length + 8, 0);
+   ctrl::Arena arena(1024);
+   ArenaTrackedRoot* newObj = ctrl::fromBinary<ArenaTrackedRoot>(bytes, length, arena);
+   delete[] bytes;
+   int destroyed = ArenaTracked::destroyed;
+   if (newObj->m_target->m_name != target.m_name) {
+      std::cout << "Target not read: ";
+      return false;
+   }
+   arena.reset();
+   if (ArenaTracked::destroyed != destroyed + 3) {
+      std::cout << "Reset destroyed " << ArenaTracked::destroyed - destroyed << " objects: ";
+      return false;
+   }
+
+   try {
+      ctrl::fromBinary<ArenaTrackedRoot>(&padded[0], padded.size(), arena);
+      std::cout << "Trailing data accepted: ";
+      return false;
+   }
+   catch (ctrl::Exception&) {
+
+   }
+   if (ArenaTracked::destroyed != destroyed + 6) {
+      std::cout << "Failed read destroyed " << ArenaTracked::destroyed - destroyed - 3 << " objects: ";
+      return false;
+   }
+   arena.reset();
+   return ArenaTracked::destroyed == destroyed + 6;
+}
+
 //******************************************************************************
 
 class ArrayContainer {
@@ -964,6 +1525,100 @@ bool testStdSharedPtr() {
    return testSerialization(obj);
 }
 
+bool testReusableWriter() {
+   std::cout << "testReusableWriter" << std::endl;
+   std::cout << "------------------" << std::endl;
+   SimpleClassStdPtrList obj;
+   std::shared_ptr<SimpleClass> ptr(new SimpleClass(0, "Gerrit"));
+   obj.add(ptr);
+   obj.add(std::shared_ptr<SimpleClass>(new SimpleClass(1, "Alex")));
+   obj.add(ptr);
+
+   long expectedLength;
+   char* expected = ctrl::toBinary(obj, expectedLength);
+   ctrl::BinaryWriter<> binaryWriter;
+   ctrl::XmlWriter xmlWriter;
+   ctrl::XmlWriter prettyXmlWriter(true);
+   ctrl::JsonWriter jsonWriter;
+   const char* previous = 0;
+   for (int i = 0; i < 2; ++i) {
+      long length;
+      const char* bytes = binaryWriter.write(obj, length);
+      if (length != expectedLength || !std::equal(bytes, bytes + length, expected)) {
+         std::cout << "Incorrect binary: ";
+         delete[] expected;
+         return false;
+      }
+      if (previous != 0 && previous != bytes) {
+         std::cout << "Binary buffer not reused: ";
+         delete[] expected;
+         return false;
+      }
+      previous = bytes;
+
+      if (xmlWriter.write(obj) != ctrl::toXml(obj) || prettyXmlWriter.write(obj) != ctrl::toXml(obj, true)) {
+         std::cout << "Incorrect XML: ";
+         delete[] expected;
+         return false;
+      }
+      if (jsonWriter.write(obj) != ctrl::toJson(obj)) {
+         std::cout << "Incorrect JSON: ";
+         delete[] expected;
+         return false;
+      }
+   }
+   delete[] expected;
+
+   ctrl::Private::XmlWriteBuffer buffer(true);
+   ctrl::toWriteBuffer(obj, buffer, 1);
+   std::string xml = buffer.getOutput();
+   if (buffer.getOutput() != xml || xml.compare(xml.length() - 9, 9, "</root>\n\n") != 0) {
+      std::cout << "Incorrect pretty printed XML: ";
+      return false;
+   }
+   return true;
+}
+
+bool testBatch() {
+   std::cout << "testBatch" << std::endl;
+   std::cout << "---------" << std::endl;
+   std::vector<SimpleClassStdPtrList> records(3);
+   std::shared_ptr<SimpleClass> ptr(new SimpleClass(0, "Gerrit"));
+   records[0].add(ptr);
+   records[0].add(ptr);
+   records[2].add(ptr);
+   records[2].add(std::shared_ptr<SimpleClass>(new SimpleClass(1, "Alex")));
+
+   long length;
+   char* bytes = ctrl::toBinaryBatch(records.begin(), records.end(), length);
+   std::vector<SimpleClassStdPtrList> result;
+   ctrl::fromBinaryBatch<SimpleClassStdPtrList>(bytes, length, std::back_inserter(result));
+   if (result.size() != records.size() || result[0].get(0) != result[0].get(1)) {
+      std::cout << "Incorrect batch: ";
+      delete[] bytes;
+      return false;
+   }
+   for (std::size_t i = 0; i < records.size(); ++i) {
+      if (!(result[i] == records[i])) {
+         std::cout << "Incorrect record: ";
+         delete[] bytes;
+         return false;
+      }
+   }
+
+   try {
+      result.clear();
+      ctrl::fromBinaryBatch<SimpleClassStdPtrList>(bytes, length - 8, std::back_inserter(result));
+      std::cout << "Truncated batch accepted: ";
+      delete[] bytes;
+      return false;
+   }
+   catch (ctrl::Exception&) { }
+
+   delete[] bytes;
+   return true;
+}
+
 //******************************************************************************
 
 class StdWeakContainer {
@@ -1348,13 +2003,523 @@ bool testPolymorph() {
    return testSerialization(drawing);
 }
 
-//******************************************************************************
-
-class PureVirtual {
+class StdDrawing {
 public:
-   PureVirtual(int val) : m_val(val) {}
-   virtual ~PureVirtual() {}
-
+   void addShape(std::shared_ptr<Shape> shape) {
+      m_shapes.push_back(shape);
+   }
+
+   bool operator==(const StdDrawing& that) const {
+      if (m_shapes.size() != that.m_shapes.size())
+         return false;
+      for (std::size_t i = 0; i < m_shapes.size(); ++i) {
+         if (!(*(m_shapes[i]) == *(that.m_shapes[i])))
+            return false;
+      }
+      return true;
+   }
+
+   CTRL_BEGIN_MEMBERS(StdDrawing)
+   CTRL_MEMBER(private, std::vector< std::shared_ptr<Shape> >, m_shapes)
+   CTRL_END_MEMBERS()
+};
+
+bool testStdPolymorph() {
+   std::cout << "testStdPolymorph" << std::endl;
+   std::cout << "----------------" << std::endl;
+
+   StdDrawing drawing;
+   std::shared_ptr<Shape> circle(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0));
+   drawing.addShape(circle);
+   drawing.addShape(std::shared_ptr<Shape>(new Rectangle(Color(127, 127, 127), 2.0, 4.0, 3.0, 3.0)));
+   drawing.addShape(circle);
+
+   return testSerialization(drawing);
+}
+
+#ifdef CTRL_INSTRUMENTATION
+bool testInstrumentation() {
+   std::cout << "testInstrumentation" << std::endl;
+   std::cout << "-------------------" << std::endl;
+
+   Drawing drawing(Color(0, 255, 0));
+   boost::shared_ptr<Shape> circle(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0));
+   drawing.addShape(circle);
+   drawing.addShape(circle);
+
+   std::vector<ctrl::Instrumentation::Call> calls;
+   ctrl::Instrumentation::reset();
+   ctrl::Instrumentation::setCallback([&calls](const ctrl::Instrumentation::Call& call) { calls.push_back(call); });
+   long length;
+   char* bytes = ctrl::toBinary(drawing, length);
+   Drawing* newDrawing = ctrl::fromBinary<Drawing>(bytes, length);
+   ctrl::Instrumentation::setCallback(ctrl::Instrumentation::Callback());
+   if (!testAndDelete(newDrawing, drawing, bytes))
+      return false;
+
+   if (calls.size() != 2 || calls[0].direction != ctrl::Instrumentation::Write ||
+       calls[1].direction != ctrl::Instrumentation::Read) {
+      std::cout << "Incorrect calls: " << calls.size() << std::endl;
+      return false;
+   }
+   for (std::size_t i = 0; i < calls.size(); ++i) {
+      const ctrl::Instrumentation::Counters& total = calls[i].total;
+      if (calls[i].typeName != "Drawing" || total.calls != 1 || total.bytes != length ||
+          total.resolvedPointers != 1 || total.repositorySize != 1) {
+         std::cout << "Incorrect totals: " << total.bytes << " bytes, " << total.resolvedPointers
+                   << " resolved pointers" << std::endl;
+         return false;
+      }
+      // The drawing, its background and one circle with its fill color.
+      if (total.objects != 4 || calls[i].types.at("Circle").objects != 1 ||
+          calls[i].types.at("Color").objects != 2 || calls[i].types.at("Drawing").bytes != total.bytes - 8) {
+         std::cout << "Incorrect objects: " << total.objects << std::endl;
+         return false;
+      }
+   }
+
+   ctrl::Instrumentation::Totals totals = ctrl::Instrumentation::totals(ctrl::Instrumentation::Write);
+   if (totals.calls["Drawing"].calls != 1 || totals.types["Circle"].objects != 1) {
+      std::cout << "Incorrect totals" << std::endl;
+      return false;
+   }
+   return true;
+}
+#endif
+
+class IntRows {
+public:
+   typedef std::vector<std::vector<int>> Rows;
+
+   CTRL_BEGIN_MEMBERS(IntRows)
+   CTRL_MEMBER(public, Rows, rows)
+   CTRL_END_MEMBERS()
+};
+
+bool testTryFrom() {
+   std::cout << "testTryFrom" << std::endl;
+   std::cout << "-----------" << std::endl;
+
+   Drawing drawing(Color(0, 255, 0));
+   boost::shared_ptr<Shape> circle(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0));
+   drawing.addShape(circle);
+   drawing.addShape(boost::shared_ptr<Shape>(new Rectangle(Color(127, 127, 127), 2.0, 4.0, 3.0, 3.0)));
+   drawing.addShape(circle);
+
+   long length;
+   char* bytes = ctrl::toBinary(drawing, length);
+   ctrl::ReadResult<Drawing> result = ctrl::tryFromBinary<Drawing>(bytes, length);
+   if (!result || !(*result.object == drawing)) {
+      std::cout << "Valid input rejected: " << result.reason << std::endl;
+      delete[] bytes;
+      return false;
+   }
+
+   for (long truncated = 0; truncated < length; ++truncated) {
+      result = ctrl::tryFromBinary<Drawing>(bytes, truncated);
+      if (result || result.position > static_cast<std::size_t>(truncated)) {
+         std::cout << "Truncated input accepted: " << truncated << std::endl;
+         delete[] bytes;
+         return false;
+      }
+   }
+
+   std::vector<char> padded(bytes, bytes + length);
+   padded.resize(length + 8, 0);
+   delete[] bytes;
+   result = ctrl::tryFromBinary<Drawing>(&padded[0], padded.size());
+   if (result || result.position != static_cast<std::size_t>(length)) {
+      std::cout << "Trailing data accepted" << std::endl;
+      return false;
+   }
+
+   std::string json = ctrl::toJson(drawing);
+   result = ctrl::tryFromJson<Drawing>(json.substr(0, json.size() / 2));
+   if (result || result.position == ctrl::Exception::unknownPosition) {
+      std::cout << "Truncated JSON accepted" << std::endl;
+      return false;
+   }
+
+   std::string xml = ctrl::toXml(drawing);
+   result = ctrl::tryFromXml<Drawing>(xml.substr(0, xml.size() / 2));
+   if (result || result.position == ctrl::Exception::unknownPosition) {
+      std::cout << "Truncated XML accepted" << std::endl;
+      return false;
+   }
+
+   result = ctrl::tryFromXml<Drawing>(xml);
+   if (!result || !(*result.object == drawing)) {
+      std::cout << "Valid XML rejected" << std::endl;
+      return false;
+   }
+
+   // A huge size followed by truncated input must be rejected before anything
+   // is allocated for it.
+   IntRows rows;
+   rows.rows.push_back(std::vector<int>(2, 7));
+   char* rowBytes = ctrl::toBinary<8, CTRL_LITTLE_ENDIAN>(rows, length);
+   const std::size_t sizes[] = { 50000000, std::size_t(1) << 40 };
+   for (std::size_t i = 0; i < 2; ++i) {
+      for (int j = 0; j < 8; ++j) {
+         rowBytes[8 + j] = static_cast<char>(sizes[i] >> (8 * j));
+      }
+      ctrl::ReadResult<IntRows> rowsResult = ctrl::tryFromBinary<IntRows, 8, CTRL_LITTLE_ENDIAN>(rowBytes, 24);
+      if (rowsResult || rowsResult.position != 16) {
+         std::cout << "Corrupt size " << sizes[i] << " not rejected at its end" << std::endl;
+         delete[] rowBytes;
+         return false;
+      }
+   }
+   delete[] rowBytes;
+   return true;
+}
+
+bool testLimits() {
+   std::cout << "testLimits" << std::endl;
+   std::cout << "----------" << std::endl;
+
+   SimpleClassVector obj;
+   obj.add(SimpleClass(5, "Gerrit"));
+   obj.add(SimpleClass(9, "Alex"));
+   obj.add(SimpleClass(11, "Kermit"));
+
+   long length;
+   char* bytes = ctrl::toBinary(obj, length);
+   std::vector<char> binary(bytes, bytes + length);
+   delete[] bytes;
+   std::string json = ctrl::toJson(obj);
+   std::string xml = ctrl::toXml(obj);
+
+   ctrl::Limits exact;
+   exact.maxDepth = 2;
+   exact.maxCollectionSize = 3;
+   exact.maxStringLength = 6;
+   exact.maxAllocation = 3 * sizeof(SimpleClass) + 16;
+
+   ctrl::ReadResult<SimpleClassVector> result = ctrl::tryFromBinary<SimpleClassVector>(&binary[0], length, exact);
+   if (!result || !(*result.object == obj)) {
+      std::cout << "Binary input within the limits rejected: " << result.reason << std::endl;
+      return false;
+   }
+   result = ctrl::tryFromJson<SimpleClassVector>(json, exact);
+   if (!result || !(*result.object == obj)) {
+      std::cout << "JSON input within the limits rejected: " << result.reason << std::endl;
+      return false;
+   }
+   result = ctrl::tryFromXml<SimpleClassVector>(xml, exact);
+   if (!result || !(*result.object == obj)) {
+      std::cout << "XML input within the limits rejected: " << result.reason << std::endl;
+      return false;
+   }
+
+   std::vector<ctrl::Limits> exceeded(4, exact);
+   --exceeded[0].maxDepth;
+   --exceeded[1].maxCollectionSize;
+   --exceeded[2].maxStringLength;
+   --exceeded[3].maxAllocation;
+   for (std::size_t i = 0; i < exceeded.size(); ++i) {
+      if (ctrl::tryFromBinary<SimpleClassVector>(&binary[0], length, exceeded[i])
+          || ctrl::tryFromJson<SimpleClassVector>(json, exceeded[i])
+          || ctrl::tryFromXml<SimpleClassVector>(xml, exceeded[i])) {
+         std::cout << "Input exceeding limit " << i << " accepted" << std::endl;
+         return false;
+      }
+   }
+
+   try {
+      SimpleClassVector* ptr = ctrl::fromBinary<SimpleClassVector>(&binary[0], length, exceeded[1]);
+      delete ptr;
+      std::cout << "fromBinary ignored the limits" << std::endl;
+      return false;
+   }
+   catch (ctrl::Exception&) {
+
+   }
+
+   return true;
+}
+
+class ReplicatedState {
+public:
+   typedef std::map<int, std::string> MapType;
+
+   CTRL_BEGIN_MEMBERS(ReplicatedState)
+   CTRL_MEMBER(public, DerivedClass, header)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, items)
+   CTRL_MEMBER(public, MapType, names)
+   CTRL_MEMBER(public, boost::shared_ptr<SimpleClass>, shared)
+   CTRL_END_MEMBERS()
+};
+
+bool testPatch(const ReplicatedState& before, const ReplicatedState& after, long& patchLength) {
+   long length;
+   char* bytes = ctrl::toBinary(before, length);
+   ReplicatedState* follower = ctrl::fromBinary<ReplicatedState>(bytes, length);
+   delete[] bytes;
+
+   char* patch = ctrl::diff(before, after, patchLength);
+   ctrl::applyPatch(*follower, patch, patchLength);
+   delete[] patch;
+
+   char* expected = ctrl::toBinary(after, length);
+   long followerLength;
+   char* actual = ctrl::toBinary(*follower, followerLength);
+   bool equal = length == followerLength && std::equal(expected, expected + length, actual);
+   delete[] expected;
+   delete[] actual;
+   delete follower;
+   return equal;
+}
+
+bool testDiff() {
+   std::cout << "testDiff" << std::endl;
+   std::cout << "--------" << std::endl;
+
+   ReplicatedState before;
+   before.header = DerivedClass(SimpleClass(3, "Gerrit"), 42, "Mostly harmless");
+   for (int i = 0; i < 100; ++i) {
+      before.items.push_back(SimpleClass(i, "Item"));
+   }
+   before.names[1] = "Alex";
+   before.shared.reset(new SimpleClass(7, "Kermit"));
+
+   long patchLength;
+   if (!testPatch(before, before, patchLength) || patchLength > 64) {
+      std::cout << "Unchanged state not patched: " << patchLength << " bytes" << std::endl;
+      return false;
+   }
+
+   ReplicatedState after(before);
+   after.header = DerivedClass(SimpleClass(3, "Gerrit"), 43, "Mostly harmless");
+   after.items[10] = SimpleClass(10, "Changed");
+   after.items.push_back(SimpleClass(100, "Appended"));
+   after.names[2] = "Ford";
+   after.shared.reset(new SimpleClass(8, "Piggy"));
+
+   long fullLength;
+   char* full = ctrl::toBinary(after, fullLength);
+   delete[] full;
+   if (!testPatch(before, after, patchLength) || patchLength * 4 > fullLength) {
+      std::cout << "Changed state not patched: " << patchLength << " of " << fullLength << " bytes" << std::endl;
+      return false;
+   }
+
+   ReplicatedState shrunk(after);
+   shrunk.items.resize(50);
+   shrunk.names.erase(1);
+   shrunk.shared.reset();
+   if (!testPatch(after, shrunk, patchLength)) {
+      std::cout << "Removals not patched" << std::endl;
+      return false;
+   }
+
+   char* patch = ctrl::diff(before, after, patchLength);
+   ReplicatedState follower(before);
+   try {
+      ctrl::applyPatch(follower, patch, patchLength / 2);
+      delete[] patch;
+      std::cout << "Truncated patch applied" << std::endl;
+      return false;
+   }
+   catch (ctrl::Exception&) {
+      delete[] patch;
+   }
+
+   return true;
+}
+
+class CachedModel {
+public:
+   bool operator==(const CachedModel& that) const {
+      return header == that.header && parts == that.parts && *shared.get() == *that.shared.get()
+          && counter == that.counter;
+   }
+
+   CTRL_BEGIN_MEMBERS(CachedModel)
+   CTRL_MEMBER(public, ctrl::Cached<CompositeClass>, header)
+   CTRL_MEMBER(public, ctrl::Cached<std::vector<SimpleClass>>, parts)
+   CTRL_MEMBER(public, ctrl::Cached<boost::shared_ptr<SimpleClass>>, shared)
+   CTRL_MEMBER(public, int, counter)
+   CTRL_END_MEMBERS()
+};
+
+class PlainModel {
+public:
+   CTRL_BEGIN_MEMBERS(PlainModel)
+   CTRL_MEMBER(public, CompositeClass, header)
+   CTRL_MEMBER(public, std::vector<SimpleClass>, parts)
+   CTRL_MEMBER(public, boost::shared_ptr<SimpleClass>, shared)
+   CTRL_MEMBER(public, int, counter)
+   CTRL_END_MEMBERS()
+};
+
+template <int alignment_>
+bool sameBinary(const CachedModel& cached, const PlainModel& plain) {
+   long cachedLength;
+   char* cachedBytes = ctrl::toBinary<alignment_>(cached, cachedLength);
+   long plainLength;
+   char* plainBytes = ctrl::toBinary<alignment_>(plain, plainLength);
+   bool equal = cachedLength == plainLength && std::equal(cachedBytes, cachedBytes + cachedLength, plainBytes);
+   delete[] cachedBytes;
+   delete[] plainBytes;
+   return equal;
+}
+
+bool testCached() {
+   std::cout << "testCached" << std::endl;
+   std::cout << "----------" << std::endl;
+
+   CachedModel cached;
+   PlainModel plain;
+   cached.header = plain.header = CompositeClass(SimpleClass(3, "Gerrit"), 42);
+   for (int i = 0; i < 10; ++i) {
+      cached.parts.mutate().push_back(SimpleClass(i, "Part"));
+      plain.parts.push_back(SimpleClass(i, "Part"));
+   }
+   cached.shared = plain.shared = boost::shared_ptr<SimpleClass>(new SimpleClass(7, "Alex"));
+   cached.counter = plain.counter = 1;
+
+   if (!sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain) || !sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain)) {
+      std::cout << "Cached encoding differs" << std::endl;
+      return false;
+   }
+
+   cached.parts.mutate()[3] = plain.parts[3] = SimpleClass(3, "Changed");
+   cached.counter = plain.counter = 2;
+   if (!sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain) || !sameBinary<1>(cached, plain)) {
+      std::cout << "Changed value not encoded" << std::endl;
+      return false;
+   }
+
+   // A change that isn't marked dirty keeps the cached encoding.
+   std::vector<SimpleClass>& parts = cached.parts.mutate();
+   if (!sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain)) {
+      std::cout << "Cached encoding differs after mutate" << std::endl;
+      return false;
+   }
+   parts[5] = SimpleClass(5, "Unmarked");
+   if (!sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain)) {
+      std::cout << "Cached encoding not reused" << std::endl;
+      return false;
+   }
+   cached.parts.markDirty();
+   plain.parts[5] = parts[5];
+   if (!sameBinary<CTRL_MEMORY_ALIGNMENT>(cached, plain)) {
+      std::cout << "Dirty value not encoded" << std::endl;
+      return false;
+   }
+
+   return testSerialization(cached);
+}
+
+class SessionMessage {
+public:
+   CTRL_BEGIN_MEMBERS(SessionMessage)
+   CTRL_MEMBER(public, int, sequence)
+   CTRL_MEMBER(public, boost::shared_ptr<SimpleClass>, reference)
+   CTRL_END_MEMBERS()
+};
+
+bool testSession() {
+   std::cout << "testSession" << std::endl;
+   std::cout << "-----------" << std::endl;
+
+   boost::shared_ptr<SimpleClass> reference(new SimpleClass(1, std::string(1000, 'x')));
+   SessionMessage message;
+   message.reference = reference;
+
+   ctrl::BinaryWriteSession<> writer;
+   ctrl::BinaryReadSession<> reader;
+   std::vector<std::unique_ptr<SessionMessage>> received;
+   std::vector<long> lengths;
+   for (int i = 0; i < 3; ++i) {
+      if (i == 2) {
+         writer.reset();
+         reader.reset();
+      }
+      message.sequence = i;
+      long length;
+      const char* bytes = writer.write(message, length);
+      received.push_back(std::unique_ptr<SessionMessage>(reader.read<SessionMessage>(bytes, length)));
+      lengths.push_back(length);
+      if (received.back()->sequence != i || !(*received.back()->reference == *reference)) {
+         std::cout << "Message " << i << " not read back" << std::endl;
+         return false;
+      }
+   }
+
+   if (lengths[1] > 64 || lengths[2] != lengths[0]) {
+      std::cout << "Shared object not sent once per session: " << lengths[1] << " " << lengths[2] << std::endl;
+      return false;
+   }
+   if (received[1]->reference != received[0]->reference || received[2]->reference == received[0]->reference) {
+      std::cout << "Shared object not shared between messages" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+bool testPolymorphConcurrent() {
+   std::cout << "testPolymorphConcurrent" << std::endl;
+   std::cout << "-----------------------" << std::endl;
+
+   Drawing drawing(Color(0, 255, 0));
+   drawing.addShape(boost::shared_ptr<Shape>(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0)));
+   drawing.addShape(boost::shared_ptr<Shape>(new Rectangle(Color(127, 127, 127), 2.0, 4.0, 3.0, 3.0)));
+
+   std::vector<char> results(4, 0);
+   std::vector<std::thread> threads;
+   for (std::size_t t = 0; t < results.size(); ++t) {
+      threads.push_back(std::thread([&drawing, &results, t]() {
+         bool success = true;
+         for (int i = 0; i < 100 && success; ++i) {
+            long length;
+            char* bytes = ctrl::toBinary(drawing, length);
+            success = testAndDelete(ctrl::fromBinary<Drawing>(bytes, length), drawing, bytes);
+         }
+         results[t] = success;
+      }));
+   }
+   for (std::size_t t = 0; t < threads.size(); ++t) {
+      threads[t].join();
+   }
+   return std::find(results.begin(), results.end(), 0) == results.end();
+}
+
+bool testFreezePolymorphicTypes() {
+   std::cout << "testFreezePolymorphicTypes" << std::endl;
+   std::cout << "--------------------------" << std::endl;
+
+   ctrl::freezePolymorphicTypes();
+   ctrl::Private::PolymorphicSerializer& registry = ctrl::Private::PolymorphicSerializer::instance();
+   std::vector<std::string> rejected = ctrl::rejectedPolymorphicTypes();
+   if ( registry.registerAbstract("LateType") != -1 || registry.isPolymorph("LateType") ||
+         ctrl::rejectedPolymorphicTypes().size() != rejected.size() + 1 ||
+         ctrl::rejectedPolymorphicTypes().back() != "LateType" ) {
+      std::cout << "Registration after freeze accepted: ";
+      return false;
+   }
+   try {
+      registry.getCast("LateType", "Shape");
+      std::cout << "Missing cast found: ";
+      return false;
+   }
+   catch (ctrl::Exception&) { }
+
+   Drawing drawing(Color(0, 255, 0));
+   drawing.addShape(boost::shared_ptr<Shape>(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0)));
+   long length;
+   char* bytes = ctrl::toBinary(drawing, length);
+   return testAndDelete(ctrl::fromBinary<Drawing>(bytes, length), drawing, bytes);
+}
+
+//******************************************************************************
+
+class PureVirtual {
+public:
+   PureVirtual(int val) : m_val(val) {}
+   virtual ~PureVirtual() {}
+
    bool operator==(const PureVirtual& that) const {
       return m_val == that.m_val;
    }
@@ -1691,6 +2856,10 @@ public:
 bool testWithVersion() {
    std::cout << "testWithVersion" << std::endl;
    std::cout << "-----------" << std::endl;
+   if (WithVersionedClass::CTRL_MemberVersion<0>::value != 1 || WithVersionedClass::CTRL_MemberVersion<1>::value != 2) {
+      std::cout << "Member versions not known at compile time" << std::endl;
+      return false;
+   }
    WithVersionedClass obj(1, 2);
 
    long length;
@@ -1767,6 +2936,229 @@ bool testCorruptData() {
    return true;
 }
 
+bool testCorruptCollectionSize() {
+   std::cout << "testCorruptCollectionSize" << std::endl;
+   std::cout << "-------------------------" << std::endl;
+
+   SimpleClassVector obj;
+   obj.add(SimpleClass(5, "Gerrit"));
+
+   long length;
+   char* data = ctrl::toBinary<8, CTRL_LITTLE_ENDIAN>(obj, length);
+   for (int i = 8; i < 15; ++i) {
+      data[i] = (char) 0xff;
+   }
+   data[15] = 0x0f;
+
+   bool failed = false;
+   try {
+      SimpleClassVector* newObj = ctrl::fromBinary<SimpleClassVector, 8, CTRL_LITTLE_ENDIAN>(data, length);
+      delete newObj;
+   } catch(const ctrl::Exception& ex) {
+      failed = true;
+   } catch(const std::bad_alloc& ex) {
+      std::cout << "Corrupt size reserved: ";
+   }
+   delete[] data;
+   return failed;
+}
+
+class LargeElement {
+public:
+   typedef std::array<double, 128> Values;
+
+   CTRL_BEGIN_MEMBERS(LargeElement)
+   CTRL_MEMBER(public, Values, values)
+   CTRL_END_MEMBERS()
+};
+
+class LargeElementVector {
+   CTRL_BEGIN_MEMBERS(LargeElementVector)
+   CTRL_MEMBER(public, std::vector<LargeElement>, elements)
+   CTRL_END_MEMBERS()
+};
+
+bool testCorruptCollectionReservation() {
+   std::cout << "testCorruptCollectionReservation" << std::endl;
+   std::cout << "--------------------------------" << std::endl;
+
+   LargeElementVector obj;
+   obj.elements.resize(2);
+
+   long length;
+   char* data = ctrl::toBinary<8, CTRL_LITTLE_ENDIAN>(obj, length);
+   for (int i = 8; i < 16; ++i) {
+      data[i] = 0;
+   }
+   data[10] = 0x10;
+
+   LargeElementVector newObj;
+   try {
+      ctrl::fromBinaryInto<LargeElementVector, 8, CTRL_LITTLE_ENDIAN>(newObj, data, length);
+      std::cout << "Corrupt size accepted" << std::endl;
+      delete[] data;
+      return false;
+   } catch(const ctrl::Exception& ex) {
+
+   }
+   delete[] data;
+   // Appending the element after the last encoded one may grow the storage once.
+   if (newObj.elements.capacity() > 4) {
+      std::cout << "Reserved " << newObj.elements.capacity() << " elements for 2 encoded ones" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+//******************************************************************************
+
+bool testJsonMemberOrder() {
+   std::cout << "testJsonMemberOrder" << std::endl;
+   std::cout << "-------------------" << std::endl;
+
+   std::string json = "{ \"unknown\" : [ 1, { \"a\" : \"}\" } ],\n"
+                      "  \"value\" : 15,\n"
+                      "  \"object\" : { \"name\" : \"K\\u00f6en \\\"\\ud83d\\ude00\\\"\", \"extra\" : null, \"count\" : -12 } }";
+   std::cout << json << std::endl;
+
+   CompositeClass* newObj = ctrl::fromJson<CompositeClass>(json);
+   CompositeClass expected(SimpleClass(-12, "K\xc3\xb6" "en \"\xf0\x9f\x98\x80\""), 15);
+   return testAndDelete(newObj, expected, 0);
+}
+
+class JsonNumbers {
+public:
+   CTRL_BEGIN_MEMBERS(JsonNumbers)
+   CTRL_MEMBER(public, int, i)
+   CTRL_MEMBER(public, unsigned int, u)
+   CTRL_MEMBER(public, std::vector<int>, v)
+   CTRL_END_MEMBERS()
+};
+
+bool testJsonTrailingData() {
+   std::cout << "testJsonTrailingData" << std::endl;
+   std::cout << "--------------------" << std::endl;
+
+   const char* invalid[] = {
+      "{\"i\":2,\"u\":3,\"v\":[]} garbage",
+      "{\"i\":2,\"u\":3,\"v\":[]}}",
+      "{\"i\":2,\"u\":3,\"v\":[]} {\"i\":3}",
+      "{\"i\":2,\"u\":3,\"v\":[],}",
+      "{\"i\":2,\"u\":3,\"v\":[1,]}",
+      "{\"v\":[],\"i\":2,\"u\":3,\"x\":{\"y\":[1,2,],\"z\":1}}",
+      "{\"i\":2147483648,\"u\":3,\"v\":[]}",
+      "{\"i\":-2147483649,\"u\":3,\"v\":[]}",
+      "{\"i\":2,\"u\":4294967296,\"v\":[]}",
+      "{\"i\":2,\"u\":3,\"v\":[2147483648]}"
+   };
+   for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+      if (ctrl::tryFromJson<JsonNumbers>(invalid[i])) {
+         std::cout << "Accepted " << invalid[i] << ": ";
+         return false;
+      }
+   }
+
+   ctrl::ReadResult<JsonNumbers> result = ctrl::tryFromJson<JsonNumbers>(
+         " { \"x\" : [ 1, { \"a\" : \"]\" } ], \"i\" : -2147483648, \"u\" : 4294967295, \"v\" : [ 1 ] } \n");
+   if (!result || result.object->i != std::numeric_limits<int>::min() || result.object->u != 4294967295u) {
+      std::cout << "Valid input rejected: " << result.reason << ": ";
+      return false;
+   }
+   return true;
+}
+
+bool testTryFromText() {
+   std::cout << "testTryFromText" << std::endl;
+   std::cout << "---------------" << std::endl;
+
+   // Recorded errors don't throw, the first one is reported.
+   const char* invalid[] = {
+      "{\"i\":2,\"u\":3,\"v\":[1,]}",
+      "{\"i\":2,\"u\":3,\"v\":[1 2]}",
+      "{\"i\":2,\"v\":[1],\"u\":-1}",
+      "{\"i\":2,\"v\":[1]}",
+      "{\"i\":\"two\",\"u\":3,\"v\":[1]}"
+   };
+   const char* reasons[] = { "expected value", "expected ',' or closing bracket", "expected unsigned integer",
+                             "no node with name 'u'", "expected integer" };
+   for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+      std::string json = invalid[i];
+      ctrl::Private::JsonReadBuffer buffer(json);
+      buffer.recordErrors();
+      try {
+         delete ctrl::fromReadBuffer<JsonNumbers>(buffer, 1);
+      } catch (ctrl::Exception& e) {
+         std::cout << "Error thrown for " << json << ": " << e.what() << ": ";
+         return false;
+      }
+      ctrl::ReadResult<JsonNumbers> result = ctrl::tryFromJson<JsonNumbers>(json);
+      if ( !buffer.failed() || result || result.reason != buffer.errorReason()
+           || result.reason.find(reasons[i]) == std::string::npos ) {
+         std::cout << "Wrong error for " << json << ": " << result.reason << ": ";
+         return false;
+      }
+   }
+
+   Drawing drawing(Color(0, 255, 0));
+   boost::shared_ptr<Shape> circle(new Circle(Color(255, 255, 0), 1.0, 2.0, 3.0));
+   drawing.addShape(circle);
+   drawing.addShape(boost::shared_ptr<Shape>(new Rectangle(Color(127, 127, 127), 2.0, 4.0, 3.0, 3.0)));
+   drawing.addShape(circle);
+   std::string json = ctrl::toJson(drawing);
+   for (std::size_t truncated = 0; truncated < json.size(); ++truncated) {
+      ctrl::ReadResult<Drawing> result = ctrl::tryFromJson<Drawing>(json.substr(0, truncated));
+      if (result || result.position == ctrl::Exception::unknownPosition) {
+         std::cout << "Truncated JSON accepted: " << truncated << ": ";
+         return false;
+      }
+   }
+
+   const char* invalidXml[] = {
+      "<root><value>15</value><object><name>Koen</name></object><__version>1</__version></root>",
+      "<root><value>15</value><object><name>K&#xZZ;</name><count>12</count></object><__version>1</__version></root>",
+      "<root><value>15</value><object><name>Koen</name><count>12</count></object></root>"
+   };
+   const char* xmlReasons[] = { "no node with name 'count'", "invalid character reference",
+                                "no node with name '__version'" };
+   for (std::size_t i = 0; i < sizeof(invalidXml) / sizeof(invalidXml[0]); ++i) {
+      std::string xml = invalidXml[i];
+      ctrl::Private::XmlReadBuffer buffer(xml);
+      buffer.recordErrors();
+      try {
+         ctrl::Context context(ctrl::ClassContext(ctrl::Private::ClassContextImpl<CompositeClass>::instance()));
+         CompositeClass obj;
+         int version;
+         buffer.readVersion(version, context);
+         ctrl::Private::deserialize(obj, buffer, 1, context);
+      } catch (ctrl::Exception& e) {
+         std::cout << "Error thrown for " << xml << ": " << e.what() << ": ";
+         return false;
+      }
+      ctrl::ReadResult<CompositeClass> result = ctrl::tryFromXml<CompositeClass>(xml);
+      if ( !buffer.failed() || result || result.reason != buffer.errorReason()
+           || result.reason.find(xmlReasons[i]) == std::string::npos ) {
+         std::cout << "Wrong error for " << xml << ": " << result.reason << ": ";
+         return false;
+      }
+   }
+   return true;
+}
+
+//******************************************************************************
+
+bool testXmlMemberOrder() {
+   std::cout << "testXmlMemberOrder" << std::endl;
+   std::cout << "------------------" << std::endl;
+
+   std::string xml = "<root><value>15</value><unknown><name>x</name></unknown>"
+                     "<object><name>Koen</name><count>12</count></object><__version>1</__version></root>";
+   std::cout << xml << std::endl;
+
+   CompositeClass* newObj = ctrl::fromXml<CompositeClass>(xml);
+   CompositeClass expected(SimpleClass(12, "Koen"), 15);
+   return testAndDelete(newObj, expected, 0);
+}
+
 //******************************************************************************
 
 class XmlAsAttributeMapElement {
@@ -1857,6 +3249,158 @@ bool testXmlWithNameAsAttribute() {
 
 //******************************************************************************
 
+bool testXmlEscaping() {
+   std::cout << "testXmlEscaping" << std::endl;
+   std::cout << "---------------" << std::endl;
+
+   XmlAsAttributeMapElement obj("<a href=\"x\">&'</a>", true);
+
+   std::string xml = ctrl::toXml(obj);
+   std::cout << xml << std::endl;
+
+   std::string expected = "<root foo=\"&lt;a href=&quot;x&quot;&gt;&amp;&apos;&lt;/a&gt;\">"
+                          "<__version>1</__version><m_bar>true</m_bar></root>";
+   if (xml != expected) {
+      std::cout << "Incorrect XML: ";
+      return false;
+   }
+   return testSerialization(obj);
+}
+
+//******************************************************************************
+
+bool testXmlInPlace() {
+   std::cout << "testXmlInPlace" << std::endl;
+   std::cout << "--------------" << std::endl;
+
+   std::string xml = "<root foo=\"&lt;&#x41;&#66;&gt;\"><__version>1</__version><m_bar>true</m_bar></root>";
+   std::string original = xml;
+   XmlAsAttributeMapElement expected("<AB>", true);
+
+   XmlAsAttributeMapElement* newObj = ctrl::fromXml<XmlAsAttributeMapElement>(xml);
+   if (xml != original) {
+      std::cout << "Input modified: ";
+      delete newObj;
+      return false;
+   }
+   if (!testAndDelete(newObj, expected, 0)) {
+      return false;
+   }
+
+   const char* invalid[] = { "&#;", "&#x;", "&#-1;", "&#+65;", "&# 65;", "&#xD800;", "&#x110000;", "&#99999999999;" };
+   for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+      std::string corrupt = "<root foo=\"" + std::string(invalid[i]) + "\"><__version>1</__version><m_bar>true</m_bar></root>";
+      if (ctrl::tryFromXml<XmlAsAttributeMapElement>(corrupt)) {
+         std::cout << "Accepted " << invalid[i] << ": ";
+         return false;
+      }
+   }
+   xml = "<root foo=\"&#x1F600;\"><__version>1</__version><m_bar>true</m_bar></root>";
+   newObj = ctrl::fromXml<XmlAsAttributeMapElement>(xml);
+   if (!testAndDelete(newObj, XmlAsAttributeMapElement("\xf0\x9f\x98\x80", true), 0)) {
+      return false;
+   }
+
+   xml = original;
+   std::vector<char> data(xml.begin(), xml.end());
+   data.push_back(0);
+   newObj = ctrl::fromXmlInPlace<XmlAsAttributeMapElement>(&data[0]);
+   return testAndDelete(newObj, expected, 0);
+}
+
+//******************************************************************************
+
+class FloatingPoint {
+public:
+   FloatingPoint(long long min, unsigned long long max) : m_min(min), m_max(max) { }
+
+   void add(double d, float f) {
+      m_doubles.push_back(d);
+      m_floats.push_back(f);
+   }
+
+   bool operator==(const FloatingPoint& that) const {
+      return m_doubles == that.m_doubles && m_floats == that.m_floats && m_min == that.m_min && m_max == that.m_max;
+   }
+
+   CTRL_BEGIN_MEMBERS(FloatingPoint)
+   CTRL_MEMBER(private, std::vector<double>, m_doubles)
+   CTRL_MEMBER(private, std::vector<float>, m_floats)
+   CTRL_MEMBER(private, long long, m_min)
+   CTRL_MEMBER(private, unsigned long long, m_max)
+   CTRL_END_MEMBERS()
+};
+
+class NonFiniteMembers {
+public:
+   CTRL_BEGIN_MEMBERS(NonFiniteMembers)
+   CTRL_MEMBER(public, double, d)
+   CTRL_MEMBER(public, float, f)
+   CTRL_MEMBER(public, ctrl::Cached<double>, c)
+   CTRL_MEMBER(public, int, i)
+   CTRL_END_MEMBERS()
+};
+
+bool testFloatingPointRoundTrip() {
+   std::cout << "testFloatingPointRoundTrip" << std::endl;
+   std::cout << "--------------------------" << std::endl;
+
+   FloatingPoint obj(-9223372036854775807LL - 1, 18446744073709551615ULL);
+   obj.add(0.1, 0.1f);
+   obj.add(1.0 / 3, 1.0f / 3);
+   obj.add(0.1 + 0.2, 16777217.0f);
+   obj.add(1e300, 3.4028235e38f);
+   obj.add(-4.9406564584124654e-324, 1.4e-45f);
+   obj.add(123456789012345678.0, -0.0f);
+
+   std::string json = ctrl::toJson(obj);
+   std::cout << json << std::endl;
+   if (json.find("[0.1,0.3333333333333333,0.30000000000000004,1e+300,") == std::string::npos) {
+      std::cout << "Incorrect JSON: ";
+      return false;
+   }
+   if (!testSerialization(obj)) {
+      return false;
+   }
+
+   FloatingPoint nonFinite(0, 0);
+   nonFinite.add(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<float>::infinity());
+   nonFinite.add(-std::numeric_limits<double>::infinity(), 1.5f);
+   json = ctrl::toJson(nonFinite);
+   if (json.find("[null,null]") == std::string::npos || json.find("[null,1.5]") == std::string::npos) {
+      std::cout << "Non finite values not written as null: " << json << std::endl;
+      return false;
+   }
+   std::unique_ptr<FloatingPoint> newObj(ctrl::fromJson<FloatingPoint>(json));
+   if (ctrl::toJson(*newObj) != json) {
+      std::cout << "Incorrect round trip of non finite elements: ";
+      return false;
+   }
+
+   NonFiniteMembers members;
+   members.d = std::numeric_limits<double>::infinity();
+   members.f = std::numeric_limits<float>::quiet_NaN();
+   members.c = -std::numeric_limits<double>::infinity();
+   members.i = 3;
+   json = ctrl::toJson(members);
+   if (json != "{\"d\":null,\"f\":null,\"c\":null,\"i\":3}") {
+      std::cout << "Non finite members not written as null: " << json << std::endl;
+      return false;
+   }
+   std::unique_ptr<NonFiniteMembers> newMembers(ctrl::fromJson<NonFiniteMembers>(json));
+   if (!std::isnan(newMembers->d) || !std::isnan(newMembers->f) || !std::isnan(newMembers->c.get()) || newMembers->i != 3) {
+      std::cout << "Non finite members not read back as NaN: ";
+      return false;
+   }
+   if (ctrl::tryFromJson<NonFiniteMembers>("{\"d\":null,\"f\":null,\"c\":null,\"i\":null}")) {
+      std::cout << "Null integer member accepted: ";
+      return false;
+   }
+   return true;
+}
+
+//******************************************************************************
+
 namespace typemanip {
 
    struct T0 {};
@@ -2190,21 +3734,31 @@ int main() {
    tests.push_back(&testDerived);
 
    tests.push_back(&testWString);
+   tests.push_back(&testWStringTranscoding);
    tests.push_back(&testSimplePair);
    tests.push_back(&testComplex);
    tests.push_back(&testValarray);
 
    tests.push_back(&testBitset);
+   tests.push_back(&testLargeBitset);
    tests.push_back(&testDeque);
    tests.push_back(&testList);
    tests.push_back(&testMap);
    tests.push_back(&testMultimap);
    tests.push_back(&testQueue);
    tests.push_back(&testPriorityQueue);
+   tests.push_back(&testPriorityQueueHeapOrder);
    tests.push_back(&testSet);
    tests.push_back(&testMultiset);
    tests.push_back(&testStack);
    tests.push_back(&testVector);
+   tests.push_back(&testParallelVector);
+   tests.push_back(&testParallelPointers);
+   tests.push_back(&testChunkIndex);
+   tests.push_back(&testNestedChunkIndex);
+   tests.push_back(&testDeserializeInto);
+   tests.push_back(&testArena);
+   tests.push_back(&testArenaDestructors);
    tests.push_back(&testArray);
    tests.push_back(&testForwardList);
    tests.push_back(&testUnorderedMap);
@@ -2216,12 +3770,24 @@ int main() {
    tests.push_back(&testWeakPtr);
    tests.push_back(&testAutoPointer);
    tests.push_back(&testStdSharedPtr);
+   tests.push_back(&testReusableWriter);
+   tests.push_back(&testBatch);
    tests.push_back(&testStdWeakPtr);
    tests.push_back(&testUniquePointer);
    tests.push_back(&testUniquePointerVector);
    tests.push_back(&testRawPointer);
 
    tests.push_back(&testPolymorph);
+   tests.push_back(&testStdPolymorph);
+   tests.push_back(&testTryFrom);
+   tests.push_back(&testLimits);
+   tests.push_back(&testDiff);
+   tests.push_back(&testCached);
+   tests.push_back(&testSession);
+#ifdef CTRL_INSTRUMENTATION
+   tests.push_back(&testInstrumentation);
+#endif
+   tests.push_back(&testPolymorphConcurrent);
    tests.push_back(&testPureVirtualFunction);
    tests.push_back(&testMultipleInheritance0);
    tests.push_back(&testMultipleInheritance1);
@@ -2232,8 +3798,17 @@ int main() {
    tests.push_back(&testBigEndian);
    tests.push_back(&testWithVersion);
    tests.push_back(&testCorruptData);
+   tests.push_back(&testCorruptCollectionSize);
+   tests.push_back(&testCorruptCollectionReservation);
+   tests.push_back(&testJsonMemberOrder);
+   tests.push_back(&testJsonTrailingData);
+   tests.push_back(&testTryFromText);
+   tests.push_back(&testXmlMemberOrder);
 
    tests.push_back(&testXmlWithNameAsAttribute);
+   tests.push_back(&testXmlEscaping);
+   tests.push_back(&testXmlInPlace);
+   tests.push_back(&testFloatingPointRoundTrip);
 
    tests.push_back(&typemanip::testTypeListContains);
    tests.push_back(&typemanip::testUniqueTypeList);
@@ -2241,6 +3816,7 @@ int main() {
    tests.push_back(&inheritance::testSingleRootAssertion);
    tests.push_back(&idfield::testGetIdField);
    tests.push_back(&testCustomIdField);
+   tests.push_back(&testFreezePolymorphicTypes);
 
    for ( typename std::vector<TestFunction>::const_iterator iter = tests.begin();
            iter != tests.end(); ++iter ) {